@@ -71,6 +71,7 @@ class cmdline_args {
   void parse_arguments(void);
   void process_mountpoints();
   void process_package();
+  void process_dl_prefetch();
 
   void build_arguments(const char* fs_mount_point, const char* fs_entry_point);
   void build_arguments_for_extract(const char* fs_mount_point);
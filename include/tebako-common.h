@@ -74,6 +74,14 @@
 #define TEBAKO_PATH_LENGTH ((size_t)2048)
 #endif
 
+// The same limit as Linux applies to symlinks followed during path resolution
+#define TEBAKO_MAX_LINK_HOPS 40
+
+// Stale file handle (tebako_open_by_handle), not defined by MSVC runtime
+#ifndef ESTALE
+#define ESTALE ENOENT
+#endif
+
 #ifdef _WIN32
 #define TEBAKO_MOUNT_POINT "A:\\__tebako_memfs__"
 #define TEBAKO_MOUNT_POINT_S "A:/__tebako_memfs__"
@@ -87,13 +95,55 @@
 #endif
 
 typedef char tebako_path_t[TEBAKO_PATH_LENGTH + 1];
+typedef uint64_t tebako_ino_t;
+
+//  Path buffer for the I/O shims
+//  Typical paths fit into the inline storage, longer ones (up to TEBAKO_PATH_LENGTH) spill to the heap.
+//  Unlike tebako_path_t it keeps shim stack frames small and is never zero-filled.
+class tebako_small_path {
+ public:
+  static constexpr size_t inline_length = 256;
+
+  tebako_small_path(void) : ptr(buf), cap(inline_length), len(0) { buf[0] = '\0'; }
+  tebako_small_path(const tebako_small_path&) = delete;
+  tebako_small_path& operator=(const tebako_small_path&) = delete;
+
+  const char* c_str(void) const { return ptr; }
+  size_t length(void) const { return len; }
+  //  The number of characters that fit without reallocation (excluding terminating '\0')
+  size_t capacity(void) const { return cap; }
+
+  //  Makes room for n characters; the content is not preserved if the storage grows
+  char* reserve(size_t n)
+  {
+    if (n > cap) {
+      heap.reset(new char[n + 1]);
+      ptr = heap.get();
+      cap = n;
+    }
+    return ptr;
+  }
+
+  void set_length(size_t n)
+  {
+    len = n;
+    ptr[n] = '\0';
+  }
+
+ private:
+  char* ptr;
+  size_t cap;
+  size_t len;
+  std::unique_ptr<char[]> heap;
+  char buf[inline_length + 1];
+};
 
-const char* tebako_get_cwd(tebako_path_t cwd, bool win_separator = false);
+const char* tebako_get_cwd(tebako_small_path& cwd, bool win_separator = false);
 bool is_tebako_path(const char* path);
 bool is_valid_system_file_descriptor(int fd);
-char* tebako_path_assign(tebako_path_t out, const std::string& in);
+char* tebako_path_assign(tebako_small_path& out, const std::string& in);
 bool tebako_set_cwd(const char* path);
-const char* to_tebako_path(tebako_path_t t_path, const char* path);
+const char* to_tebako_path(tebako_small_path& t_path, const char* path);
 
 #ifdef RB_W32
 #define TO_RB_W32(A) ::rb_w32_##A
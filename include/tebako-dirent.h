@@ -82,6 +82,9 @@ typedef union tebako_dirent {
 namespace tebako {
 const size_t TEBAKO_DIR_CACHE_SIZE = 50;
 
+// Fills directory cache entry for the file name and its stat
+void fill_dirent(tebako_dirent& entry, const std::string& name, const struct stat& st, off_t offset) noexcept;
+
 struct tebako_ds {
   tebako_dirent cache[TEBAKO_DIR_CACHE_SIZE];
   size_t dir_size;
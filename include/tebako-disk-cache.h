@@ -0,0 +1,124 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+
+namespace tebako {
+
+// disk_cache_entry
+// Decompressed content of one file mapped from the persistent cache
+class disk_cache_entry {
+ public:
+  disk_cache_entry(void* map, size_t map_size, const char* data, size_t size)
+      : map_(map), map_size_(map_size), data_(data), size_(size)
+  {
+  }
+  ~disk_cache_entry();
+
+  disk_cache_entry(const disk_cache_entry&) = delete;
+  disk_cache_entry& operator=(const disk_cache_entry&) = delete;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // CLOCK reference bit, see disk_cache::insert
+  void touch() const { referenced_.store(true, std::memory_order_relaxed); }
+  bool test_and_clear_referenced() const { return referenced_.exchange(false, std::memory_order_relaxed); }
+
+ private:
+  void* map_;
+  size_t map_size_;
+  const char* data_;
+  size_t size_;
+  mutable std::atomic<bool> referenced_{false};
+};
+
+// disk_cache
+// Persistent cache of decompressed files that survives process restarts
+// Cache files are stored in <root>/<image id>/<inode>, image id is derived from the
+// image size and the hash of the whole image. Each file carries a crc32c checksum
+// of its content that is verified when the file is mapped. Cache files are written
+// to a temporary name and renamed, so that concurrent processes never see partial data.
+// At most max_mapped_entries files are kept mapped at a time.
+class disk_cache {
+ public:
+  static constexpr size_t default_max_entry_size = static_cast<size_t>(16) << 20;
+  static constexpr size_t default_max_mapped_entries = 4096;
+
+  disk_cache(const std::string& root,
+             const void* image,
+             size_t image_size,
+             size_t max_entry_size,
+             size_t max_mapped_entries = default_max_mapped_entries);
+
+  disk_cache(const disk_cache&) = delete;
+  disk_cache& operator=(const disk_cache&) = delete;
+
+  // Returns cached content of the file or nullptr
+  // cacheable is set to false if the file has been rejected earlier
+  std::shared_ptr<const disk_cache_entry> get(uint32_t inode, bool& cacheable) noexcept;
+  // Stores the file and returns its cached content (nullptr if the file cannot be cached)
+  std::shared_ptr<const disk_cache_entry> put(uint32_t inode, const void* data, size_t size) noexcept;
+  // Marks the file as not cacheable
+  void reject(uint32_t inode) noexcept;
+
+  size_t max_entry_size() const { return max_entry_size_; }
+  size_t mapped_entries() const;
+  const std::string& directory() const { return directory_; }
+
+  static std::string image_id(const void* image, size_t image_size);
+
+ private:
+  struct entry_table {
+    std::unordered_map<uint32_t, std::shared_ptr<const disk_cache_entry>> entries;  // nullptr if rejected
+    std::deque<uint32_t> clock;                                                     // mapped entries
+  };
+
+  std::shared_ptr<const disk_cache_entry> map_entry(uint32_t inode);
+  std::shared_ptr<const disk_cache_entry> insert(uint32_t inode, std::shared_ptr<const disk_cache_entry> entry);
+  std::string entry_path(uint32_t inode) const;
+
+  std::string directory_;
+  size_t max_entry_size_;
+  size_t max_mapped_entries_;
+  bool directory_ok_;
+  folly::Synchronized<entry_table> entries_;
+};
+
+}  // namespace tebako
@@ -66,11 +66,14 @@ class sync_tebako_fdtable {
  private:
   folly::Synchronized<tebako_fdtable> s_tebako_fdtable;
 
+  int insert(std::shared_ptr<tebako_fd> fd, int flags) noexcept;
+
  public:
   static sync_tebako_fdtable& get_tebako_fdtable(void);
 
   int open(const char* path, int flags, std::string& lnk) noexcept;
   int openat(int vfd, const char* path, int flags, std::string& lnk) noexcept;
+  int open_inode(tebako_ino_t inode, int flags) noexcept;
   int close(int vfd) noexcept;
   void close_all(void) noexcept;
   int fstat(int vfd, struct stat* st) noexcept;
@@ -0,0 +1,65 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace tebako {
+
+// huge_page_image
+// This class asks the kernel to back memfs image with transparent huge pages in place:
+// the huge page aligned part of the image is advised with MADV_HUGEPAGE, the image is
+// neither copied nor moved. If THP is not available (not Linux, disabled by the kernel,
+// the image is smaller than a huge page, madvise failure) nothing is changed.
+// Decompressed block buffers are allocated by dwarfs block cache and are not affected.
+
+class huge_page_image {
+ public:
+  static constexpr size_t huge_page_size = static_cast<size_t>(2) << 20;
+
+  huge_page_image(const void* data, size_t size);
+
+  huge_page_image(const huge_page_image&) = delete;
+  huge_page_image& operator=(const huge_page_image&) = delete;
+
+  const void* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool is_huge() const { return area_size_ != 0; }
+  size_t huge_size() const { return area_size_; }  // bytes of the image advised for huge pages
+
+  static bool thp_available(void);
+
+ private:
+  const void* data_;
+  size_t size_;
+  size_t area_size_;
+};
+
+}  // namespace tebako
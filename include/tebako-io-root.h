@@ -30,6 +30,8 @@
 #pragma once
 
 namespace tebako {
+class memfs;
+
 int mount_root_memfs(const void* data,
                      const unsigned int size,
                      const char* debuglevel,
@@ -44,25 +46,30 @@ int mount_memfs(const void* data, const unsigned int size, const char* image_off
 int mount_memfs(const void* data,
                 const unsigned int size,
                 const char* image_offset,
-                uint32_t parent_inode,
+                tebako_ino_t parent_inode,
                 const char* path);
 
+int mount_memfs(std::shared_ptr<memfs> fs, tebako_ino_t parent_inode, const char* path);
+int mount_memfs_overlay(const std::vector<std::shared_ptr<memfs>>& layers, tebako_ino_t parent_inode, const char* path);
+
 void unmount_root_memfs(void);
+void register_fork_handlers(void) noexcept;
 
 int dwarfs_access(const std::string&, int amode, uid_t uid, gid_t gid, std::string& lnk) noexcept;
 int dwarfs_lstat(const std::string&, struct stat* buf, std::string& lnk) noexcept;
 int dwarfs_readlink(const std::string& path, std::string& link, std::string& lnk) noexcept;
+int dwarfs_realpath(const std::string& path, std::string& canonical, std::string& lnk) noexcept;
 int dwarfs_stat(const std::string& path, struct stat* buf, std::string& lnk, bool follow) noexcept;
 
-int dwarfs_inode_access(uint32_t inode, int amode, uid_t uid, gid_t gid) noexcept;
+int dwarfs_inode_access(tebako_ino_t inode, int amode, uid_t uid, gid_t gid) noexcept;
 int dwarfs_relative_stat(const std::string& path, struct stat* st, std::string& lnk, bool follow) noexcept;
-int dwarfs_inode_relative_stat(uint32_t inode,
+int dwarfs_inode_relative_stat(tebako_ino_t inode,
                                const std::string& path,
                                struct stat* buf,
                                std::string& lnk,
                                bool follow) noexcept;
-ssize_t dwarfs_inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept;
-int dwarfs_inode_readdir(uint32_t inode,
+ssize_t dwarfs_inode_read(tebako_ino_t inode, void* buf, size_t size, off_t offset) noexcept;
+int dwarfs_inode_readdir(tebako_ino_t inode,
                          tebako::tebako_dirent* cache,
                          off_t cache_start,
                          size_t buffer_size,
@@ -55,10 +55,13 @@ int mount_root_memfs(const void* data,
 
 int mount_memfs_at_root(const void* data, const unsigned int size, const char* image_offset, const char* path);
 
+/* parent_inode is the composite inode (st_ino) of the directory to mount at.
+   It was 'unsigned int' before composite inodes became 64-bit; callers built against
+   the old declaration shall be recompiled (ABI change) */
 int mount_memfs(const void* data,
                 const unsigned int size,
                 const char* image_offset,
-                unsigned int parent_inode,
+                uint64_t parent_inode,
                 const char* path);
 
 void unmount_root_memfs(void);
@@ -66,6 +69,23 @@ void unmount_root_memfs(void);
 char* tebako_getcwd(char* buf, size_t size);
 int tebako_chdir(const char* path);
 
+#define TEBAKO_EXTRACT_SKIP_UNCHANGED 0x1
+int tebako_extract(const char* src, const char* dest, int options);
+
+typedef void (*tebako_read_cb)(const char* path, const void* data, size_t size, int err, void* ctx);
+typedef int (*tebako_name_filter)(const char* name, void* ctx);
+int tebako_read_many(const char* const* paths, size_t n, tebako_read_cb cb, void* ctx);
+int tebako_read_dir_files(const char* dir, tebako_name_filter filter, void* filter_ctx, tebako_read_cb cb, void* ctx);
+
+int tebako_prefork_warmup(const char* const* paths, size_t n);
+
+int tebako_resolve_feature(const char* feature,
+                           const char* const* load_path,
+                           size_t n,
+                           const char* const* exts,
+                           char* out_path,
+                           size_t out_size);
+
 /* Another option -- to be cleaned if 'defined(_SYS_STAT_H)' works
 #if defined(__mode_t_defined) || defined(_MODE_T) || defined(__NEED_mode_t)
     __mode_t_defined    -- Ubuntu/GNU
@@ -75,6 +95,14 @@ int tebako_chdir(const char* path);
 #endif
 */
 
+/* Opaque reference to a memfs file, valid until the memfs table changes */
+struct tebako_file_handle {
+  uint64_t inode;      /* composite inode, memfs index and inode within it */
+  uint64_t generation; /* memfs table generation when the handle was made */
+};
+int tebako_name_to_handle(const char* path, struct tebako_file_handle* handle);
+int tebako_open_by_handle(const struct tebako_file_handle* handle, int flags);
+
 int tebako_access(const char* path, int amode);
 #ifdef TEBAKO_HAS_EACCESS
 int tebako_eaccess(const char* path, int amode);
@@ -136,6 +164,7 @@ int tebako_fstatat(int fd, const char* path, struct stat* buf, int flag);
 
 int tebako_close(int vfd);
 ssize_t tebako_readlink(const char* path, char* buf, size_t bufsiz);
+char* tebako_realpath(const char* path, char* resolved_path);
 
 /* DIR and struct dirent is defined only if dirent.h has been included
     In Ruby eenvironment
@@ -180,6 +209,9 @@ int tebako_scandir(const char* dir,
 void* tebako_dlopen(const char* path, int flags);
 char* tebako_dlerror(void);
 char* tebako_dlmap2file(const char* path);
+void tebako_set_dl_cache(const char* dir);
+int tebako_dl_prefetch(const char* const* paths, size_t n);
+int tebako_dl_prefetch_from_env(void);
 
 #if defined(TEBAKO_HAS_DIRFD) || defined(RB_W32)
 int tebako_flock(int vfd, int operation);
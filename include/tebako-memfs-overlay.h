@@ -0,0 +1,81 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+// memfs_overlay
+// Union of several memfs images mounted at the same mount point
+// Layers are stacked bottom to top, upper layers shadow lower ones.
+//
+// Whiteouts follow OCI image layout: a file named ".wh.<name>" hides <name> of the
+// lower layers, a file named ".wh..wh..opq" makes the directory opaque, i.e. the content
+// of lower layers is not merged into it. Whiteout files themselves are not listed.
+//
+// The index is built at mount time and is sparse: it records only the paths whose layer
+// differs from the layer of the parent directory, so that a path is resolved by the longest
+// indexed prefix. Directories that exist in several layers are merged; readdir on such
+// directory lists the union of the layers
+class memfs_overlay {
+ private:
+  struct merged_entry {
+    std::string name;
+    struct stat st;                  // st_ino is composite inode of the topmost entry
+    std::vector<tebako_ino_t> dirs;  // directory in the layers to merge, topmost first
+  };
+
+  std::vector<uint32_t> layers;                                             // memfs indices, top layer last
+  std::unordered_map<std::string, uint32_t> index;                          // path --> memfs index
+  std::unordered_map<tebako_ino_t, std::vector<tebako_ino_t>> merged_dirs;  // topmost inode --> dirs to merge
+
+  static int merge(const std::vector<tebako_ino_t>& dirs, std::vector<merged_entry>& entries) noexcept;
+
+ public:
+  static constexpr const char* whiteout_prefix = ".wh.";
+  static constexpr const char* opaque_marker = ".wh..wh..opq";
+
+  explicit memfs_overlay(std::vector<uint32_t> layer_indices) : layers(std::move(layer_indices)) {}
+
+  int build_index(void) noexcept;
+  uint32_t resolve(const stdfs::path& path) const;
+
+  bool is_merged_dir(tebako_ino_t inode) const { return merged_dirs.find(inode) != merged_dirs.end(); }
+  int readdir(tebako_ino_t inode,
+              tebako_dirent* cache,
+              off_t cache_start,
+              size_t buffer_size,
+              size_t& cache_size,
+              size_t& dir_size) const noexcept;
+
+  std::vector<uint32_t> const& get_layers(void) const { return layers; }
+  size_t index_size(void) const { return index.size(); }
+};
+
+}  // namespace tebako
@@ -38,32 +38,87 @@ typedef ino_t _ino_t;
 
 typedef std::map<uint32_t, std::shared_ptr<memfs>> tebako_memfs_table;
 
+// Immutable copy of memfs table published to readers, index --> memfs (nullptr if not mounted)
+struct memfs_table_snapshot {
+  std::vector<std::shared_ptr<memfs>> slots;
+};
+
+// memfs_table_reader
+// Read-side critical section for the memfs table snapshot (RCU style)
+// While any reader is active the snapshot it may have loaded, and memfs instances referenced
+// by this snapshot, are not released. Each thread announces its readers with an epoch counter
+// of its own, so entering and leaving touches no shared cache line. Readers may be nested.
+class memfs_table_reader {
+ public:
+  memfs_table_reader();
+  ~memfs_table_reader();
+
+  memfs_table_reader(const memfs_table_reader&) = delete;
+  memfs_table_reader& operator=(const memfs_table_reader&) = delete;
+
+  static bool active(void);
+};
+
+// sync_tebako_memfs_table
+// The map is the writers' copy, changed under the lock by mount and unmount.
+// Every change publishes a new snapshot and waits until readers of the previous one are gone.
 class sync_tebako_memfs_table {
  private:
   folly::Synchronized<tebako_memfs_table> s_tebako_memfs_table;
+  std::optional<folly::Synchronized<tebako_memfs_table>::WLockedPtr> fork_lock;
+  std::atomic<uint64_t> generation{0};
+  std::atomic<memfs_table_snapshot*> snapshot{new memfs_table_snapshot};
+  std::vector<memfs_table_snapshot*> retired;  // released by the next publish, guarded by the map lock
+
+  void publish(const tebako_memfs_table& table);
 
  public:
   static sync_tebako_memfs_table& get_tebako_memfs_table(void);
 
-  static constexpr int inoBits = std::min(sizeof(_ino_t), sizeof(uint32_t)) * 8;
-  static const int fsBits = 1;
-  static constexpr int inoMask = ((static_cast<_ino_t>(1) << (inoBits - fsBits)) - 1);
-  static constexpr int fsMask = ((static_cast<_ino_t>(1) << fsBits) - 1);
+  sync_tebako_memfs_table() = default;
+  ~sync_tebako_memfs_table();
 
-  static int getFsIndex(_ino_t ino) { return (ino >> (inoBits - fsBits)) & fsMask; }
-  static _ino_t getFsIno(_ino_t ino) { return ino & inoMask; }
+  // Composite inode is [ memfs index | dwarfs inode ]
+  // If ino_t is 64-bit the upper TEBAKO_MEMFS_INDEX_BITS bits store memfs index,
+  // otherwise (Windows) three bits are used, i.e. root memfs and up to seven mounted images.
+  // With 16-bit _ino_t this leaves 13 bits, so an image may have at most 8192 inodes (checked at load)
+  static constexpr int inoBits = std::min(sizeof(_ino_t), sizeof(tebako_ino_t)) * 8;
+  static constexpr int fsBits = inoBits >= 64 ? TEBAKO_MEMFS_INDEX_BITS : 3;
+  static_assert(fsBits >= 1 && fsBits <= 32, "TEBAKO_MEMFS_INDEX_BITS shall be in the range [1, 32]");
 
-  static _ino_t fsInoFromFsAndIno(int index, _ino_t ino)
+  static constexpr tebako_ino_t inoMask = ((static_cast<tebako_ino_t>(1) << (inoBits - fsBits)) - 1);
+  static constexpr uint32_t fsMask = static_cast<uint32_t>((static_cast<tebako_ino_t>(1) << fsBits) - 1);
+
+  static uint32_t getFsIndex(tebako_ino_t ino) { return (ino >> (inoBits - fsBits)) & fsMask; }
+  static tebako_ino_t getFsIno(tebako_ino_t ino) { return ino & inoMask; }
+
+  static tebako_ino_t fsInoFromFsAndIno(uint32_t index, tebako_ino_t ino)
   {
-    return (static_cast<_ino_t>(index) << (inoBits - fsBits)) | getFsIno(ino);
+    return (static_cast<tebako_ino_t>(index) << (inoBits - fsBits)) | getFsIno(ino);
   }
 
+  // Whether every inode of an image with this number of inodes has a composite inode
+  static bool fitsInodeCount(uint64_t count) { return count <= static_cast<uint64_t>(inoMask) + 1; }
+
   bool check(uint32_t index);
   void clear(void);
   void erase(uint32_t index);
   std::shared_ptr<memfs> get(uint32_t index);
+  // No lock and no reference counting; the caller shall hold memfs_table_reader while using the pointer
+  memfs* peek(uint32_t index) const
+  {
+    const memfs_table_snapshot* snap = snapshot.load(std::memory_order_acquire);
+    return index < snap->slots.size() ? snap->slots[index].get() : nullptr;
+  }
   bool insert(uint32_t index, std::shared_ptr<memfs> fs);
   uint32_t insert_auto(std::shared_ptr<memfs> fs);
+
+  // Changes whenever a memfs is mounted or unmounted, so that caches of resolved paths can be invalidated
+  uint64_t get_generation(void) const { return generation.load(std::memory_order_acquire); }
+
+  // fork support: the table is locked before fork and unlocked in both processes after it
+  void lock_for_fork(void);
+  void unlock_after_fork(bool child);
 };
 
 template <typename Functor, class... Args>
@@ -71,11 +126,12 @@ int memfs_call(Functor&& fn, uint32_t fs_index, Args&&... args)
 {
   int ret = DWARFS_IO_ERROR;
 
-  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(fs_index);
+  memfs_table_reader reader;
+  memfs* fs = sync_tebako_memfs_table::get_tebako_memfs_table().peek(fs_index);
   if (fs == nullptr) {
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
-  else {
+  else if (fs->ensure_loaded() == DWARFS_IO_CONTINUE) {
     ret = ((*fs).*fn)(std::forward<Args>(args)...);
   }
   return ret;
@@ -88,16 +144,17 @@ int root_memfs_call(Functor&& fn, Args&&... args)
 }
 
 template <typename Functor, class... Args>
-int inode_memfs_call(Functor&& fn, uint32_t inode, Args&&... args)
+int inode_memfs_call(Functor&& fn, tebako_ino_t inode, Args&&... args)
 {
   int ret = DWARFS_IO_ERROR;
   uint32_t fs_index = sync_tebako_memfs_table::getFsIndex(inode);
 
-  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(fs_index);
+  memfs_table_reader reader;
+  memfs* fs = sync_tebako_memfs_table::get_tebako_memfs_table().peek(fs_index);
   if (fs == nullptr) {
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
-  else {
+  else if (fs->ensure_loaded() == DWARFS_IO_CONTINUE) {
     ret = ((*fs).*fn)(inode, std::forward<Args>(args)...);
   }
   return ret;
@@ -38,6 +38,11 @@
 #include "dwarfs/options.h"
 #include "dwarfs/util.h"
 
+#include "tebako-huge-pages.h"
+#include "tebako-disk-cache.h"
+#include "tebako-shared-cache.h"
+#include "tebako-stat-cache.h"
+
 void tebako_init_cwd(dwarfs::logger& lgr, bool need_debug_policy);
 void tebako_drop_cwd(void);
 
@@ -47,21 +52,51 @@ struct memfs_options {
   int readonly{0};
   int cache_image{0};
   int enable_nlink{0};
+  int huge_pages{0};
+  int lazy_mount{0};
   size_t cachesize{(static_cast<size_t>(512) << 20)};
   size_t workers{2};
+  std::string disk_cache_dir;  // Persistent cache of decompressed files, disabled if empty
+  size_t disk_cache_max_entry{disk_cache::default_max_entry_size};
+  size_t shared_cache_size{0};  // Size of cache shared by forked processes, disabled if 0
+  size_t shared_cache_max_entry{shared_cache::default_max_entry_size};
   dwarfs::mlock_mode lock_mode{dwarfs::mlock_mode::NONE};
   double decompress_ratio{0.8};
   dwarfs::logger::level_type debuglevel{dwarfs::logger::level_type::INFO};
 };
 
+// Filesystem tree entry reported by memfs::list_tree and memfs::list_dir
+struct memfs_tree_entry {
+  std::string path;    // relative to the listed subtree, '/' separated; "" for the subtree root
+  struct stat st;      // st_ino is composite inode [ memfs index | dwarfs inode ]
+  std::string link;    // symlink target
+  uint32_t data_rank;  // position of the file data in the image
+};
+
 class memfs {
  private:
+  std::vector<char> owned_image;  // Image memory if it is owned by memfs
   const void* data;
   const unsigned int size;
-  uint32_t dwarfs_root_inode;
+  tebako_ino_t dwarfs_root_inode;
 
   dwarfs::filesystem_options fsopts;
+  std::unique_ptr<huge_page_image> hp_image;  // Huge page advice for the image memory
   dwarfs::filesystem_v2 fs;
+  std::unique_ptr<disk_cache> dcache;
+  std::unique_ptr<shared_cache> scache;
+  inode_stat_cache stat_cache;
+
+  // Lazy mount support
+  // memfs is registered in deferred state and loaded on the first access
+  enum class load_state { loaded, deferred, failed };
+  std::atomic<load_state> state{load_state::loaded};
+  std::unique_ptr<std::once_flag> deferred_load_flag{std::make_unique<std::once_flag>()};
+  std::string deferred_image_offset;
+
+  // Inode --> order of its data in the image, built on the first request
+  std::once_flag data_ranks_flag;
+  std::vector<uint32_t> data_ranks;
 
   //  std::shared_ptr<dwarfs::performance_monitor> perfmon;
 
@@ -69,35 +104,44 @@ class memfs {
   static void set_cachesize(const char* cachesize);
   static void set_debuglevel(const char* debuglevel);
   static void set_decompress_ratio(const char* decompress_ratio);
+  static void set_disk_cache(const char* directory);
+  static void set_huge_pages(const char* huge_pages);
+  static void set_lazy_mount(const char* lazy_mount);
   static void set_lock_mode(const char* mlock);
+  static void set_shared_cache(const char* size);
   static void set_workers(const char* workers);
 
   static dwarfs::stream_logger& logger();
   static memfs_options& options();
 
-  memfs(const void* dt, const unsigned int sz, uint32_t df_root = 0);
+  memfs(const void* dt, const unsigned int sz, tebako_ino_t df_root = 0);
+  memfs(std::vector<char>&& image, tebako_ino_t df_root = 0);
 
   int load(const char* image_offset = "auto");
+  void defer_load(const char* image_offset = "auto");
+  int ensure_loaded(void) noexcept;
+  void reload_after_fork(void) noexcept;
+  bool is_loaded(void) const { return state.load(std::memory_order_acquire) == load_state::loaded; }
   void set_image_offset_str(const char* image_offset = "auto");
-  uint32_t get_root_inode(void) { return dwarfs_root_inode; }
-  void set_root_inode(uint32_t df_root_inode) { dwarfs_root_inode = df_root_inode; }
+  tebako_ino_t get_root_inode(void) { return dwarfs_root_inode; }
+  void set_root_inode(tebako_ino_t df_root_inode) { dwarfs_root_inode = df_root_inode; }
 
   int access(const std::string& path, int amode, uid_t uid, gid_t gid, std::string& lnk) noexcept;
-  int inode_access(uint32_t inode, int amode, uid_t uid, gid_t gid) noexcept;
-  ssize_t inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept;
-  int inode_readdir(uint32_t inode,
+  int inode_access(tebako_ino_t inode, int amode, uid_t uid, gid_t gid) noexcept;
+  ssize_t inode_read(tebako_ino_t inode, void* buf, size_t size, off_t offset) noexcept;
+  int inode_readdir(tebako_ino_t inode,
                     tebako_dirent* cache,
                     off_t cache_start,
                     size_t buffer_size,
                     size_t& cache_size,
                     size_t& dir_size) noexcept;
-  int inode_readlink(uint32_t inode, std::string& lnk) noexcept;
+  int inode_readlink(tebako_ino_t inode, std::string& lnk) noexcept;
 
   int stat(const std::string& path, struct stat* st, std::string& lnk, bool follow) noexcept
   {
     return find_inode_root(path, follow, lnk, st);
   }
-  int inode_relative_stat(uint32_t inode,
+  int inode_relative_stat(tebako_ino_t inode,
                           const std::string& path,
                           struct stat* st,
                           std::string& lnk,
@@ -118,34 +162,60 @@ class memfs {
 #endif
 
   int readlink(const std::string& path, std::string& link, std::string& lnk) noexcept;
+  int realpath(const std::string& path, std::string& canonical, std::string& lnk) noexcept;
+  int dir_entries(tebako_ino_t inode,
+                  std::function<void(const std::string& name, const struct stat& st)> const& fn) noexcept;
+  int list_tree(tebako_ino_t inode, std::vector<memfs_tree_entry>& entries) noexcept;
+  int list_dir(tebako_ino_t inode, std::vector<memfs_tree_entry>& entries) noexcept;
+  uint32_t inode_data_rank(tebako_ino_t inode) noexcept;
+
+  static constexpr uint32_t no_data_rank = UINT32_MAX;
 
  private:
   int i_access(int amode, struct stat* st);
 
   int dwarfs_file_stat(dwarfs::inode_view& inode, struct stat* st);
+  int cached_stat(dwarfs::inode_view& inode, struct stat* st);
+
+  uint32_t to_dwarfs_inode(tebako_ino_t inode) const;
+  std::shared_ptr<const disk_cache_entry> disk_cached_file(tebako_ino_t inode) noexcept;
+  ssize_t shared_cached_read(tebako_ino_t inode, void* buf, size_t size, off_t offset) noexcept;
+  tebako_ino_t to_tebako_inode(tebako_ino_t inode) const;
 
-  int find_inode(uint32_t start_from,
+  int find_inode(tebako_ino_t start_from,
                  const stdfs::path& path,
                  bool follow_last,
                  std::string& lnk,
-                 struct stat* st) noexcept;
-  int find_inode_abs(uint32_t start_from,
+                 struct stat* st) noexcept
+  {
+    return (this->*find_inode_p)(start_from, path, follow_last, lnk, st);
+  }
+  template <typename LoggerPolicy>
+  int find_inode_impl(tebako_ino_t start_from,
+                      const stdfs::path& path,
+                      bool follow_last,
+                      std::string& lnk,
+                      struct stat* st) noexcept;
+  int find_inode_abs(tebako_ino_t start_from,
                      const stdfs::path& path,
                      bool follow,
                      std::string& lnk,
                      struct stat* st) noexcept;
   int find_inode_root(const std::string& path, bool follow, std::string& lnk, struct stat* st) noexcept;
+  int resolve_path(const stdfs::path& path, std::string& canonical, std::string& lnk) noexcept;
 
   int process_inode(dwarfs::inode_view& pi,
-                    dwarfs::file_stat* st,
+                    struct stat* st,
                     bool follow,
                     std::string& lnk,
                     stdfs::path::iterator& p_iterator,
                     stdfs::path& p_path);
   int process_link(std::string& lnk, stdfs::path::iterator& p_iterator, stdfs::path& p_path);
 
-  template <typename Functor, class... Args>
-  int safe_dwarfs_call(Functor&& fn, const char* caller, uint32_t inode, Args&&... args);
+  // find_inode instantiation for the logger policy, chosen once by set_debuglevel
+  // With prod_logger_policy debug logging compiles away from the path lookup loop
+  typedef int (memfs::*find_inode_fn)(tebako_ino_t, const stdfs::path&, bool, std::string&, struct stat*) noexcept;
+  static find_inode_fn find_inode_p;
 };
 
 }  // namespace tebako
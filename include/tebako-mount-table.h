@@ -31,42 +31,63 @@
 
 namespace tebako {
 
-typedef std::pair<uint32_t, std::string> tebako_mount_point;
-typedef std::variant<std::string, uint32_t> tebako_mount_target;
+class memfs_overlay;
+
+typedef std::pair<tebako_ino_t, std::string> tebako_mount_point;
+typedef std::variant<std::string, uint32_t, std::shared_ptr<memfs_overlay>> tebako_mount_target;
 typedef std::map<tebako_mount_point, tebako_mount_target> tebako_mount_table;
 
 class sync_tebako_mount_table {
  private:
   folly::Synchronized<tebako_mount_table> s_tebako_mount_table;
+  std::optional<folly::Synchronized<tebako_mount_table>::WLockedPtr> fork_lock;
+  std::atomic<uint64_t> generation{0};
+  std::atomic<size_t> overlays{0};  // Number of overlay mount points
 
  public:
   static sync_tebako_mount_table& get_tebako_mount_table(void);
 
   bool check(const tebako_mount_point& mount_point);
-  bool check(const uint32_t ino, const std::string& mount_path) { return check(std::make_pair(ino, mount_path)); };
+  bool check(const tebako_ino_t ino, const std::string& mount_path) { return check(std::make_pair(ino, mount_path)); };
 
   void clear(void);
 
   void erase(const tebako_mount_point& mount_point);
-  void erase(const uint32_t ino, const std::string& mount_path) { erase(std::make_pair(ino, mount_path)); };
+  void erase(const tebako_ino_t ino, const std::string& mount_path) { erase(std::make_pair(ino, mount_path)); };
 
   std::optional<tebako_mount_target> get(const tebako_mount_point& mount_point);
-  std::optional<tebako_mount_target> get(const uint32_t ino, const std::string& mount_path)
+  std::optional<tebako_mount_target> get(const tebako_ino_t ino, const std::string& mount_path)
   {
     return get(std::make_pair(ino, mount_path));
   };
 
   bool insert(const tebako_mount_point& mount_point, const std::string& mount_target);
-  bool insert(const uint32_t ino, const std::string& mount_path, const std::string& mount_target)
+  bool insert(const tebako_ino_t ino, const std::string& mount_path, const std::string& mount_target)
   {
     return insert(std::make_pair(ino, mount_path), mount_target);
   };
 
   bool insert(const tebako_mount_point& mount_point, uint32_t mount_target);
-  bool insert(const uint32_t ino, const std::string& mount_path, uint32_t mount_target)
+  bool insert(const tebako_ino_t ino, const std::string& mount_path, uint32_t mount_target)
   {
     return insert(std::make_pair(ino, mount_path), mount_target);
   };
+
+  bool insert(const tebako_mount_point& mount_point, std::shared_ptr<memfs_overlay> mount_target);
+  bool insert(const tebako_ino_t ino, const std::string& mount_path, std::shared_ptr<memfs_overlay> mount_target)
+  {
+    return insert(std::make_pair(ino, mount_path), std::move(mount_target));
+  };
+
+  // Returns the overlay that merges directory inode of its layers, nullptr if the directory is not merged
+  std::shared_ptr<memfs_overlay> get_merged_dir_overlay(tebako_ino_t inode);
+
+  // Changes whenever a mount point is added or removed, so that caches of resolved paths can be invalidated
+  uint64_t get_generation(void) const { return generation.load(std::memory_order_acquire); }
+
+  // fork support: the table is locked before fork and unlocked in both processes after it
+  void lock_for_fork(void) { fork_lock.emplace(s_tebako_mount_table.wlock()); }
+  void unlock_after_fork(void) { fork_lock.reset(); }
 };
 
 }  // namespace tebako
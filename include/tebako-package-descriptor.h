@@ -49,6 +49,7 @@ class package_descriptor {
   std::string mount_point;
   std::string entry_point;
   std::optional<std::string> cwd;
+  std::vector<std::string> dl_prefetch;  // shared objects to extract in background at mount
 
  public:
   // Deleted default constructor
@@ -61,7 +62,8 @@ class package_descriptor {
                      const std::string& tebako_version,
                      const std::string& mount_point,
                      const std::string& entry_point,
-                     const std::optional<std::string>& cwd);
+                     const std::optional<std::string>& cwd,
+                     const std::vector<std::string>& dl_prefetch = {});
   // Serialize the object to a binary format
   std::vector<char> serialize() const;
 
@@ -74,6 +76,7 @@ class package_descriptor {
   const std::string& get_mount_point() const { return mount_point; }
   const std::string& get_entry_point() const { return entry_point; }
   const std::optional<std::string>& get_cwd() const { return cwd; }
+  const std::vector<std::string>& get_dl_prefetch() const { return dl_prefetch; }
 
   static bool is_little_endian()
   {
@@ -102,6 +105,7 @@ class package_descriptor {
   }
 
   static const char* signature;
+  static const char* dl_prefetch_signature;
 };
 
 }  // namespace tebako
@@ -35,21 +35,32 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <optional>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <variant>
 #include <vector>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <filesystem>
 namespace stdfs = std::filesystem;
@@ -0,0 +1,97 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+
+namespace tebako {
+
+// shared_cache
+// Cache of decompressed files in a shared anonymous memory region
+// The region is created when memfs is loaded, so that all worker processes forked
+// by a prefork server share the files decompressed by any of them, and a restarted
+// worker finds the cache warm.
+//
+// The index is an open addressing table of slots. Each slot is claimed and published
+// with compare-and-swap on its state word [ inode | epoch | tag ], there are no locks
+// that a crashed process may leave behind. When the data budget is exhausted the
+// whole cache is flushed: the epoch is advanced and the slots of the previous epoch
+// become invalid. Readers check that the epoch did not change while they copied data.
+// Flush waits for the writers that are copying data of the previous epoch before the
+// data area is reused.
+class shared_cache {
+ public:
+  static constexpr size_t default_max_entry_size = static_cast<size_t>(1) << 20;
+
+  // read results other than the number of bytes
+  static constexpr ssize_t miss = -1;           // not cached, put may be tried
+  static constexpr ssize_t not_cacheable = -2;  // put has been rejected
+
+  shared_cache(size_t region_size, size_t max_entry_size);
+  ~shared_cache();
+
+  shared_cache(const shared_cache&) = delete;
+  shared_cache& operator=(const shared_cache&) = delete;
+
+  bool is_available() const { return header != nullptr; }
+  size_t max_entry_size() const { return max_entry_size_; }
+  uint64_t epoch() const;
+
+  ssize_t read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept;
+  bool put(uint32_t inode, const void* data, size_t size) noexcept;
+  void reject(uint32_t inode) noexcept;
+
+ private:
+  struct region_header;
+  struct slot;
+
+  slot* find_slot(uint32_t inode, uint64_t epoch, uint64_t tag, bool& claimed) noexcept;
+  bool begin_write(uint64_t epoch) noexcept;
+  void end_write(uint64_t epoch) noexcept;
+  void flush(uint64_t epoch) noexcept;
+  bool validate(uint32_t inode, uint64_t epoch, uint64_t offset, uint64_t size, uint32_t crc) noexcept;
+
+  void* region;
+  size_t region_size;
+  size_t max_entry_size_;
+  region_header* header;
+  slot* slots;
+  char* data_area;
+
+  // Entries which checksums have been verified by this process [ inode --> epoch ]
+  folly::Synchronized<std::unordered_map<uint32_t, uint64_t>> validated;
+};
+
+}  // namespace tebako
@@ -0,0 +1,75 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace tebako {
+
+// inode_stat_cache
+// Dense cache of stat structures indexed by dwarfs inode number, sized from the inode count of the image.
+// The image is read-only, so every slot is written once and never invalidated. Slots are allocated in
+// chunks on the first access to any of their inodes; chunks and slots are published with atomic
+// compare-and-swap, so neither lookup nor fill takes a lock.
+
+class inode_stat_cache {
+ public:
+  static constexpr uint32_t chunk_bits = 10;
+  static constexpr uint32_t chunk_size = static_cast<uint32_t>(1) << chunk_bits;
+
+  inode_stat_cache() = default;
+  ~inode_stat_cache();
+
+  inode_stat_cache(const inode_stat_cache&) = delete;
+  inode_stat_cache& operator=(const inode_stat_cache&) = delete;
+
+  // Sets the number of inodes, only the first call has effect
+  void reserve(size_t inode_count);
+  size_t capacity() const { return count; }
+
+  const struct stat* get(uint32_t ino) const noexcept;
+  void put(uint32_t ino, const struct stat& st) noexcept;
+
+ private:
+  enum slot_state : uint8_t { slot_empty, slot_filling, slot_ready };
+
+  struct chunk {
+    std::atomic<uint8_t> state[chunk_size];
+    struct stat st[chunk_size];
+  };
+
+  size_t count{0};
+  std::unique_ptr<std::atomic<chunk*>[]> chunks;
+};
+
+}  // namespace tebako
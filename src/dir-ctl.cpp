@@ -40,7 +40,7 @@ using namespace tebako;
 
 char* tebako_getcwd(char* buf, size_t size)
 {
-  tebako_path_t _cwd;
+  tebako_small_path _cwd;
   const char* cwd = tebako_get_cwd(_cwd, true);
   size_t len = strlen(cwd);
   if (len) {
@@ -92,7 +92,7 @@ int tebako_chdir(const char* path)
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
 
     if (p_path) {
@@ -137,7 +137,7 @@ int tebako_mkdir(const char* path)
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       std::string lnk;
@@ -171,7 +171,7 @@ int tebako_rmdir(const char* path)
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       std::string lnk;
@@ -197,7 +197,7 @@ int tebako_unlink(const char* path)
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       std::string lnk;
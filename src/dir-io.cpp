@@ -49,7 +49,7 @@ DIR* tebako_opendir(const char* dirname)
   }
   else {
     int vfd;
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     std::string r_dirname = dirname;
     const char* p_path = to_tebako_path(t_path, dirname);
 
@@ -233,7 +233,7 @@ int tebako_scandir(const char* dirname,
     int vfd;
     std::string dirname_r = dirname;
     DIR* dirp = NULL;
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, dirname);
 
     if (p_path) {
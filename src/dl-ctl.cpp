@@ -37,6 +37,12 @@
 #include <tebako-io-root.h>
 #include <tebako-fd.h>
 
+#include <folly/hash/SpookyHashV2.h>
+
+#ifdef TEBAKO_HAS_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
+
 using namespace std;
 
 struct tebako_dlerror_data {
@@ -49,11 +55,12 @@ struct tebako_dlerror_data {
 static folly::Synchronized<tebako_dlerror_data> tebako_dlerror_stash;
 static char tebako_dlerror_msg[TEBAKO_PATH_LENGTH + 1024];
 
-typedef map<string, string> tebako_dltable;
+typedef map<string, std::shared_future<string>> tebako_dltable;
 
 class sync_tebako_dltable : public folly::Synchronized<tebako_dltable*> {
  private:
   stdfs::path dl_tmpdir;
+  std::mutex dl_tmpdir_mutex;
 
   void create_temporary_directory(void)
   {
@@ -81,20 +88,272 @@ class sync_tebako_dltable : public folly::Synchronized<tebako_dltable*> {
 
   void map_name(const char* path, std::string& mapped)
   {
+    stdfs::path _mapped;
+    {
+      std::lock_guard<std::mutex> lock(dl_tmpdir_mutex);
+      if (dl_tmpdir.empty()) {
+        create_temporary_directory();
+      }
+      _mapped = dl_tmpdir;
+    }
     const char* adj = path[TEBAKO_MOUNT_POINT_LENGTH] == '\0' ? path + TEBAKO_MOUNT_POINT_LENGTH
                                                               : path + TEBAKO_MOUNT_POINT_LENGTH + 1;
-    stdfs::path _mapped = dl_tmpdir / adj;
+    _mapped /= adj;
     stdfs::create_directories(_mapped.parent_path());
     mapped = _mapped.make_preferred().string();
   }
 
+  // Copies memfs file to the host file
+  static bool copy(int fh_in, size_t f_size, int fh_out)
+  {
+    const int bsize = 16 * 1024;
+    char buf[bsize];
+    ssize_t r_size;
+    while (f_size > 0 && (r_size = tebako_read(fh_in, buf, bsize)) > 0) {
+      if (r_size != ::write(fh_out, buf, r_size))
+        break;
+      f_size -= r_size;
+    }
+    return f_size == 0;
+  }
+
+  // Extracts memfs file to the temporary directory
+  static bool extract(int fh_in, const struct STAT_TYPE& st, const std::string& mapped)
+  {
+    bool ret = false;
+    int fh_out = ::open(mapped.c_str(), O_WRONLY | O_CREAT | O_BINARY, st.st_mode);
+    if (fh_out >= 0) {
+      ret = copy(fh_in, st.st_size, fh_out);
+      ::close(fh_out);
+      if (!ret) {
+        ::unlink(mapped.c_str());
+      }
+    }
+    return ret;
+  }
+
+  // Extracts memfs file to the temporary directory, via the cache if it is enabled
+  bool extract_file(int fh_in,
+                    const struct STAT_TYPE& st,
+                    const char* path,
+                    const stdfs::path& cache,
+                    std::string& mapped)
+  {
+    map_name(path, mapped);
+    return cache.empty() ? extract(fh_in, st, mapped) : extract_cached(fh_in, st, cache, mapped);
+  }
+
+  // Anonymous memory file
+  // On Linux the library is loaded from memfd sealed against modifications, so nothing
+  // is written to disk. The descriptor stays open and the library is available as
+  // /proc/self/fd/N in this process and its forks.
+  // The temporary directory (or the cache) is used if memfd cannot be created or
+  // if the persistent cache has been enabled by tebako_set_dl_cache
+  static constexpr const char* memfd_prefix = "/proc/self/fd/";
+
+  static bool is_memfd(const std::string& mapped) { return mapped.rfind(memfd_prefix, 0) == 0; }
+
+  static bool extract_memfd(int fh_in, const struct STAT_TYPE& st, const char* path, std::string& mapped)
+  {
+#ifdef TEBAKO_HAS_MEMFD_CREATE
+    std::string name = stdfs::path(path).filename().string();
+    unsigned int flags = MFD_CLOEXEC | MFD_ALLOW_SEALING;
+#ifdef MFD_EXEC
+    // Kernels that default to non-executable memfd require explicit MFD_EXEC,
+    // older kernels reject the flag
+    int fd = ::memfd_create(name.c_str(), flags | MFD_EXEC);
+    if (fd < 0 && errno == EINVAL) {
+      fd = ::memfd_create(name.c_str(), flags);
+    }
+#else
+    int fd = ::memfd_create(name.c_str(), flags);
+#endif
+    if (fd < 0) {
+      return false;
+    }
+
+    bool ret = copy(fh_in, st.st_size, fd);
+#ifdef F_ADD_SEALS
+    ret = ret && ::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+#endif
+    if (!ret) {
+      ::close(fd);
+      tebako_lseek(fh_in, 0, SEEK_SET);
+      return false;
+    }
+    mapped = memfd_prefix + std::to_string(fd);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Content-addressed cache of extracted files
+  // A file is stored once as <cache>/<SpookyHashV2 of its content> and is hard-linked (or copied)
+  // to the temporary directory, so that the relative layout of shared libraries is kept.
+  // Cache entries that have not been used for cache_ttl are removed.
+  static constexpr auto cache_ttl = std::chrono::hours(24 * 30);
+  static constexpr auto cache_tmp_ttl = std::chrono::hours(24);
+
+  stdfs::path dl_cache;  // guarded by the table lock
+  std::atomic<bool> cache_cleaned{false};
+
+  static stdfs::path default_cache_directory(void)
+  {
+    const char* base = ::getenv("XDG_CACHE_HOME");
+    if (base != nullptr && *base != '\0') {
+      return stdfs::path(base) / "tebako" / "dl";
+    }
+#ifdef _WIN32
+    base = ::getenv("LOCALAPPDATA");
+    if (base != nullptr && *base != '\0') {
+      return stdfs::path(base) / "tebako" / "dl";
+    }
+#else
+    base = ::getenv("HOME");
+    if (base != nullptr && *base != '\0') {
+      return stdfs::path(base) / ".cache" / "tebako" / "dl";
+    }
+#endif
+    return stdfs::temp_directory_path() / "tebako-dl-cache";
+  }
+
+  static bool content_hash(int fh_in, size_t f_size, std::string& digest)
+  {
+    std::vector<char> buf(1024 * 1024);
+    folly::hash::SpookyHashV2 spooky;
+    spooky.Init(0, 0);
+    ssize_t r_size;
+    while (f_size > 0 && (r_size = tebako_read(fh_in, buf.data(), buf.size())) > 0) {
+      spooky.Update(buf.data(), r_size);
+      f_size -= r_size;
+    }
+    if (f_size != 0 || tebako_lseek(fh_in, 0, SEEK_SET) != 0) {
+      return false;
+    }
+
+    uint64_t h1, h2;
+    spooky.Final(&h1, &h2);
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << h1 << std::setw(16) << h2;
+    digest = ss.str();
+    return true;
+  }
+
+  static void clean_cache(const stdfs::path& cache)
+  {
+    std::error_code ec;
+    auto now = stdfs::file_time_type::clock::now();
+    for (auto it = stdfs::directory_iterator(cache, ec); !ec && it != stdfs::directory_iterator();
+         it.increment(ec)) {
+      auto ttl = it->path().extension() == ".tmp" ? cache_tmp_ttl : cache_ttl;
+      std::error_code ec_entry;
+      auto mtime = it->last_write_time(ec_entry);
+      if (!ec_entry && now - mtime > ttl) {
+        stdfs::remove(it->path(), ec_entry);
+      }
+    }
+  }
+
+  bool extract_cached(int fh_in, const struct STAT_TYPE& st, const stdfs::path& cache, const std::string& mapped)
+  {
+    std::error_code ec;
+    if (!cache_cleaned.exchange(true)) {
+      stdfs::create_directories(cache, ec);
+      clean_cache(cache);
+    }
+
+    std::string digest;
+    if (!content_hash(fh_in, st.st_size, digest)) {
+      return false;
+    }
+
+    // Cheap verification: the name is the hash of the content, the size shall match
+    stdfs::path cached = cache / digest;
+    auto c_size = stdfs::file_size(cached, ec);
+    if (ec || c_size != static_cast<uintmax_t>(st.st_size)) {
+      std::stringstream tmp;
+      tmp << digest << "." << ::getpid() << "." << std::hash<std::thread::id>{}(std::this_thread::get_id()) << ".tmp";
+      std::string cached_tmp = (cache / tmp.str()).string();
+      if (!extract(fh_in, st, cached_tmp)) {
+        return extract_from_memfs(fh_in, st, mapped);
+      }
+      stdfs::rename(cached_tmp, cached, ec);
+      if (ec) {
+        stdfs::remove(cached_tmp, ec);
+        return extract_from_memfs(fh_in, st, mapped);
+      }
+    }
+    else {
+      stdfs::last_write_time(cached, stdfs::file_time_type::clock::now(), ec);  // Keep it alive
+    }
+
+    stdfs::create_hard_link(cached, mapped, ec);
+    if (ec) {
+      stdfs::copy_file(cached, mapped, stdfs::copy_options::overwrite_existing, ec);
+    }
+    return !ec;
+  }
+
+  static bool extract_from_memfs(int fh_in, const struct STAT_TYPE& st, const std::string& mapped)
+  {
+    return tebako_lseek(fh_in, 0, SEEK_SET) == 0 && extract(fh_in, st, mapped);
+  }
+
+  // Background prefetch
+  // Shared objects listed by the package or by TEBAKO_DL_PREFETCH are extracted by a small pool
+  // of threads at mount, tebako_dlopen waits for the prefetch of the same library if it is in
+  // progress (see map2file). The threads are joined at exit; a forked child does not have
+  // them, so it leaks their handles instead.
+  struct prefetch_queue {
+    std::vector<std::string> paths;
+    std::atomic<size_t> next{0};
+  };
+
+  static constexpr size_t max_prefetchers = 4;
+
+  std::mutex prefetch_mutex;
+  std::vector<std::unique_ptr<std::thread>> prefetchers;
+  pid_t prefetch_pid = 0;
+
+  void prefetch_worker(std::shared_ptr<prefetch_queue> queue)
+  {
+    for (size_t i = queue->next++; i < queue->paths.size(); i = queue->next++) {
+      // Missing files are left to the lazy path, so that prefetch does not set dlerror
+      const char* path = queue->paths[i].c_str();
+      if (tebako_access(path, R_OK) == 0) {
+        map2file(path);
+      }
+    }
+  }
+
+  void join_prefetchers(void)
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    for (auto& t : prefetchers) {
+      if (prefetch_pid == ::getpid()) {
+        t->join();
+      }
+      else {
+        t.release();
+      }
+    }
+    prefetchers.clear();
+  }
+
  public:
-  sync_tebako_dltable(void) : folly::Synchronized<tebako_dltable*>(new tebako_dltable) { create_temporary_directory(); }
+  sync_tebako_dltable(void) : folly::Synchronized<tebako_dltable*>(new tebako_dltable) {}
   ~sync_tebako_dltable(void)
   {
+    join_prefetchers();
     auto p_dltable = *wlock();
     for (auto it = p_dltable->begin(); it != p_dltable->end(); ++it) {
-      ::unlink(it->second.c_str());
+      if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        const string& mapped = it->second.get();
+        if (!mapped.empty() && !is_memfd(mapped)) {
+          ::unlink(mapped.c_str());
+        }
+      }
     }
     p_dltable->clear();
     if (!dl_tmpdir.empty()) {
@@ -103,64 +362,100 @@ class sync_tebako_dltable : public folly::Synchronized<tebako_dltable*> {
     }
   }
 
+  // sync_tebako_dltable::map2file
+  //  Extracts memfs file to the host, once per path
+  //  The table lock is held only to find or to insert the entry. The first caller extracts
+  //  the file, concurrent callers for the same path wait for its result, so different
+  //  libraries are extracted in parallel
   string map2file(const char* path)
   {
-    string ret = "";
-    auto p_dltable = *wlock();
-    auto p_dl = p_dltable->find(path);
-    if (p_dl != p_dltable->end()) {
-      ret = p_dl->second;
+    std::promise<string> promise;
+    std::shared_future<string> result;
+    stdfs::path cache;
+    {
+      auto p_dltable = *wlock();
+      auto p_dl = p_dltable->find(path);
+      if (p_dl != p_dltable->end()) {
+        result = p_dl->second;
+      }
+      else {
+        cache = dl_cache;
+        (*p_dltable)[path] = promise.get_future().share();
+      }
     }
-    else {
-      try {
-        std::string mapped;
-        map_name(path, mapped);
-        int fh_in = tebako_open(2, path, O_RDONLY);
-        size_t f_size = 0;
-        if (fh_in < 0) {
-          *tebako_dlerror_stash.wlock() = tebako_dlerror_data(ENOENT, path);
-          fh_in = -1;
+
+    if (!result.valid()) {
+      string ret = extract_to_host(path, cache);
+      promise.set_value(ret);
+      if (ret.empty()) {
+        // Do not keep failures, the next call will try again
+        auto p_dltable = *wlock();
+        p_dltable->erase(path);
+      }
+      return ret;
+    }
+    return result.get();
+  }
+
+ private:
+  string extract_to_host(const char* path, const stdfs::path& cache)
+  {
+    string ret = "";
+    try {
+      std::string mapped;
+      int fh_in = tebako_open(2, path, O_RDONLY);
+      if (fh_in < 0) {
+        *tebako_dlerror_stash.wlock() = tebako_dlerror_data(ENOENT, path);
+      }
+      else {
+        struct STAT_TYPE st;
+        if (tebako_fstat(fh_in, &st) == -1) {
+          *tebako_dlerror_stash.wlock() = tebako_dlerror_data(EIO, path);
+        }
+        else if ((cache.empty() && extract_memfd(fh_in, st, path, mapped)) ||
+                 extract_file(fh_in, st, path, cache, mapped)) {
+          ret = std::move(mapped);
         }
         else {
-          struct STAT_TYPE st;
-          if (tebako_fstat(fh_in, &st) == -1) {
-            *tebako_dlerror_stash.wlock() = tebako_dlerror_data(EIO, path);
-          }
-          else {
-            int fh_out = ::open(mapped.c_str(), O_WRONLY | O_CREAT | O_BINARY, st.st_mode);
-            if (fh_out < 0) {
-              *tebako_dlerror_stash.wlock() = tebako_dlerror_data(EIO, path);
-            }
-            else {
-              f_size = st.st_size;
-              const int bsize = 16 * 1024;
-              char buf[bsize];
-              ssize_t r_size;
-              while (f_size > 0 && (r_size = tebako_read(fh_in, buf, bsize)) > 0) {
-                f_size -= r_size;
-                if (r_size != ::write(fh_out, buf, r_size))
-                  break;
-              }
-              if (f_size == 0) {
-                ret = mapped;
-                (*p_dltable)[path] = std::move(mapped);
-              }
-              else {
-                ::unlink(mapped.c_str());
-                *tebako_dlerror_stash.wlock() = tebako_dlerror_data(EIO, path);
-              }
-              ::close(fh_out);
-            }
-          }
-          tebako_close(fh_in);
+          *tebako_dlerror_stash.wlock() = tebako_dlerror_data(EIO, path);
         }
-      }
-      catch (...) {
-        *tebako_dlerror_stash.wlock() = tebako_dlerror_data(ENOMEM, path);
+        tebako_close(fh_in);
       }
     }
+    catch (...) {
+      *tebako_dlerror_stash.wlock() = tebako_dlerror_data(ENOMEM, path);
+    }
     return ret;
   }
+
+ public:
+  // Starts background extraction of the shared objects (tebako paths)
+  size_t prefetch(std::vector<std::string> paths)
+  {
+    if (paths.empty()) {
+      return 0;
+    }
+    auto queue = std::make_shared<prefetch_queue>();
+    queue->paths = std::move(paths);
+    size_t n_threads = std::min(queue->paths.size(), max_prefetchers);
+
+    std::lock_guard<std::mutex> lock(prefetch_mutex);
+    prefetch_pid = ::getpid();
+    for (size_t i = 0; i < n_threads; ++i) {
+      prefetchers.push_back(std::make_unique<std::thread>(&sync_tebako_dltable::prefetch_worker, this, queue));
+    }
+    return queue->paths.size();
+  }
+
+  // Enables content-addressed cache of extracted files
+  // NULL disables the cache, empty string selects default location
+  void set_cache(const char* dir)
+  {
+    auto lock = wlock();
+    dl_cache = (dir == nullptr) ? stdfs::path() : (*dir == '\0' ? default_cache_directory() : stdfs::path(dir));
+    cache_cleaned = false;
+  }
+
   static sync_tebako_dltable dltable;
 };
 
@@ -174,7 +469,7 @@ extern "C" void* tebako_dlopen(const char* path, int flags)
     ret = ::dlopen(path, flags);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (!p_path) {
       ret = ::dlopen(path, flags);
@@ -193,7 +488,7 @@ extern "C" char* tebako_dlmap2file(const char* path)
 {
   char* ret = NULL;
   if (path != NULL) {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       string mapped_path = sync_tebako_dltable::dltable.map2file(p_path);
@@ -205,6 +500,78 @@ extern "C" char* tebako_dlmap2file(const char* path)
   return ret;
 }
 
+// tebako_dl_prefetch
+//  Starts background extraction of the shared objects, so that tebako_dlopen finds them ready
+//  Paths outside of memfs are ignored
+//
+// returns
+//  the number of shared objects scheduled for extraction
+//  -1 - error [errno is set]
+extern "C" int tebako_dl_prefetch(const char* const* paths, size_t n)
+{
+  if (paths == NULL && n != 0) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+
+  try {
+    std::vector<std::string> p_paths;
+    for (size_t i = 0; i < n; ++i) {
+      tebako_small_path t_path;
+      const char* p_path = paths[i] != NULL ? to_tebako_path(t_path, paths[i]) : NULL;
+      if (p_path) {
+        p_paths.emplace_back(p_path);
+      }
+    }
+    return static_cast<int>(sync_tebako_dltable::dltable.prefetch(std::move(p_paths)));
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+}
+
+// tebako_dl_prefetch_from_env
+//  Starts background extraction of the shared objects listed by TEBAKO_DL_PREFETCH
+//  (separated by ':', or by ';' on Windows)
+extern "C" int tebako_dl_prefetch_from_env(void)
+{
+#ifdef _WIN32
+  const char separator = ';';
+#else
+  const char separator = ':';
+#endif
+  const char* list = ::getenv("TEBAKO_DL_PREFETCH");
+  if (list == NULL || *list == '\0') {
+    return 0;
+  }
+
+  try {
+    std::vector<std::string> paths;
+    std::stringstream ss(list);
+    std::string path;
+    while (std::getline(ss, path, separator)) {
+      if (!path.empty()) {
+        paths.push_back(std::move(path));
+      }
+    }
+    std::vector<const char*> p_paths;
+    for (const auto& p : paths) {
+      p_paths.push_back(p.c_str());
+    }
+    return tebako_dl_prefetch(p_paths.data(), p_paths.size());
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+}
+
+extern "C" void tebako_set_dl_cache(const char* dir)
+{
+  sync_tebako_dltable::dltable.set_cache(dir);
+}
+
 extern "C" char* tebako_dlerror(void)
 {
   string tebako_dlerror_text;
@@ -31,10 +31,13 @@
 #include <tebako-pch-pp.h>
 #include <tebako-common.h>
 #include <tebako-dirent.h>
+#include <tebako-memfs.h>
 #include <tebako-io.h>
 #include <tebako-io-inner.h>
 #include <tebako-io-rb-w32-inner.h>
 #include <tebako-io-root.h>
+#include <tebako-memfs-table.h>
+#include <tebako-mount-table.h>
 
 using namespace tebako;
 
@@ -46,7 +49,7 @@ int tebako_access(const char* path, int amode)
   }
   else {
     std::string lnk;
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       ret = dwarfs_access(p_path, amode, getuid(), getgid(), lnk);
@@ -70,7 +73,7 @@ int tebako_eaccess(const char* path, int amode)
   }
   else {
     std::string lnk;
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       ret = dwarfs_access(p_path, amode, geteuid(), getegid(), lnk);
@@ -95,7 +98,7 @@ int tebako_lstat(const char* path, struct STAT_TYPE* buf)
   }
   else {
     std::string r_path;
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
 #ifdef _WIN32
@@ -124,7 +127,7 @@ ssize_t tebako_readlink(const char* path, char* buf, size_t bufsize)
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       std::string link;
@@ -146,6 +149,112 @@ ssize_t tebako_readlink(const char* path, char* buf, size_t bufsize)
   return ret;
 }
 
+//  Memoized results of tebako_realpath
+//  Only paths resolved without leaving memfs are stored (memfs content is immutable);
+//  the cache is dropped when the memfs or mount table changes
+struct tebako_realpath_cache {
+  uint64_t memfs_generation{0};
+  uint64_t mount_generation{0};
+  std::unordered_map<std::string, std::string> paths;
+};
+
+static folly::Synchronized<tebako_realpath_cache> realpath_cache;
+static const size_t realpath_cache_max_entries = 16384;
+
+static char* host_realpath(const char* path, char* resolved_path)
+{
+#ifdef _WIN32
+  return _fullpath(resolved_path, path, TEBAKO_PATH_LENGTH);
+#else
+  return ::realpath(path, resolved_path);
+#endif
+}
+
+static char* realpath_result(const std::string& canonical, char* resolved_path)
+{
+  char* ret = NULL;
+  if (canonical.length() >= TEBAKO_PATH_LENGTH) {
+    TEBAKO_SET_LAST_ERROR(ENAMETOOLONG);
+  }
+  else if (resolved_path == NULL) {
+    ret = strdup(canonical.c_str());
+    if (ret == NULL) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+    }
+  }
+  else {
+    ret = strcpy(resolved_path, canonical.c_str());
+  }
+  return ret;
+}
+
+char* tebako_realpath(const char* path, char* resolved_path)
+{
+  if (path == NULL) {
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+    return NULL;
+  }
+
+  tebako_small_path t_path;
+  const char* p_path = to_tebako_path(t_path, path);
+  if (p_path == NULL) {
+    return host_realpath(path, resolved_path);
+  }
+
+  try {
+    auto& memfs_table = sync_tebako_memfs_table::get_tebako_memfs_table();
+    auto& mount_table = sync_tebako_mount_table::get_tebako_mount_table();
+    uint64_t memfs_generation = memfs_table.get_generation();
+    uint64_t mount_generation = mount_table.get_generation();
+    {
+      auto cache = realpath_cache.rlock();
+      if (cache->memfs_generation == memfs_generation && cache->mount_generation == mount_generation) {
+        auto cached = cache->paths.find(p_path);
+        if (cached != cache->paths.end()) {
+          return realpath_result(cached->second, resolved_path);
+        }
+      }
+    }
+
+    std::string current = p_path;
+    std::string canonical;
+    std::string lnk;
+    for (int hops = 0;; hops++) {
+      int ret = dwarfs_realpath(current, canonical, lnk);
+      if (ret == DWARFS_IO_CONTINUE) {
+        break;
+      }
+      if (ret != DWARFS_S_LINK_ABSOLUTE) {
+        return NULL;
+      }
+      if (!is_tebako_path(lnk.c_str())) {
+        return host_realpath(lnk.c_str(), resolved_path);
+      }
+      if (hops >= TEBAKO_MAX_LINK_HOPS) {
+        TEBAKO_SET_LAST_ERROR(ELOOP);
+        return NULL;
+      }
+      current = std::move(lnk);
+    }
+
+    {
+      auto cache = realpath_cache.wlock();
+      if (cache->memfs_generation != memfs_generation || cache->mount_generation != mount_generation ||
+          cache->paths.size() >= realpath_cache_max_entries) {
+        cache->paths.clear();
+        cache->memfs_generation = memfs_generation;
+        cache->mount_generation = mount_generation;
+      }
+      cache->paths.emplace(p_path, canonical);
+    }
+    return realpath_result(canonical, resolved_path);
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return NULL;
+  }
+}
+
 int tebako_stat(const char* path, struct STAT_TYPE* buf)
 {
   int ret = -1;
@@ -154,7 +263,7 @@ int tebako_stat(const char* path, struct STAT_TYPE* buf)
   }
   else {
     std::string lnk;
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
 #ifdef RB_W32
@@ -186,7 +295,7 @@ int tebako_getattrlist(const char* path,
     TEBAKO_SET_LAST_ERROR(EFAULT);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     const char* p_path = to_tebako_path(t_path, path);
     if (p_path) {
       TEBAKO_SET_LAST_ERROR(ENOTSUP);
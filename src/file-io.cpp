@@ -36,6 +36,8 @@
 #include <tebako-io-rb-w32-inner.h>
 #include <tebako-io-root.h>
 #include <tebako-fd.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
 
 using namespace tebako;
 
@@ -46,7 +48,7 @@ int tebako_open(int nargs, const char* path, int flags, ...)
     TEBAKO_SET_LAST_ERROR(ENOENT);
   }
   else {
-    tebako_path_t t_path;
+    tebako_small_path t_path;
     std::string r_path = path;
     const char* p_path = to_tebako_path(t_path, path);
 
@@ -76,6 +78,64 @@ int tebako_open(int nargs, const char* path, int flags, ...)
   return ret;
 }
 
+// tebako_name_to_handle
+//  Resolves a memfs path (following symlinks) once, so that the file can be reopened with
+//  tebako_open_by_handle without path resolution
+//
+// returns
+//  0 - success [handle is set]
+//  -1 - error [errno is set, EOPNOTSUPP if the path resolves outside of memfs]
+int tebako_name_to_handle(const char* path, struct tebako_file_handle* handle)
+{
+  int ret = -1;
+  if (path == NULL || handle == NULL) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+  }
+  else {
+    tebako_small_path t_path;
+    const char* p_path = to_tebako_path(t_path, path);
+    if (p_path == NULL) {
+      TEBAKO_SET_LAST_ERROR(EOPNOTSUPP);
+    }
+    else {
+      struct stat st;
+      std::string lnk;
+      uint64_t generation = sync_tebako_memfs_table::get_tebako_memfs_table().get_generation();
+      ret = dwarfs_stat(p_path, &st, lnk, true);
+      if (ret == DWARFS_S_LINK_OUTSIDE) {
+        TEBAKO_SET_LAST_ERROR(EOPNOTSUPP);
+        ret = -1;
+      }
+      else if (ret == DWARFS_IO_CONTINUE) {
+        handle->inode = st.st_ino;
+        handle->generation = generation;
+      }
+    }
+  }
+  return ret;
+}
+
+// tebako_open_by_handle
+//  Opens memfs file referenced by the handle, the same way as tebako_open does
+//
+// returns
+//  file descriptor - success
+//  -1 - error [errno is set, ESTALE if memfs has been mounted or unmounted since the handle was made]
+int tebako_open_by_handle(const struct tebako_file_handle* handle, int flags)
+{
+  int ret = -1;
+  if (handle == NULL) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+  }
+  else if (handle->generation != sync_tebako_memfs_table::get_tebako_memfs_table().get_generation()) {
+    TEBAKO_SET_LAST_ERROR(ESTALE);
+  }
+  else {
+    ret = sync_tebako_fdtable::get_tebako_fdtable().open_inode(handle->inode, flags);
+  }
+  return ret;
+}
+
 #ifdef TEBAKO_HAS_OPENAT
 int tebako_openat(int nargs, int vfd, const char* path, int flags, ...)
 {
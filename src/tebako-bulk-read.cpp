@@ -0,0 +1,245 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-dirent.h>
+#include <tebako-memfs.h>
+#include <tebako-io.h>
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs-table.h>
+
+using namespace tebako;
+
+namespace {
+
+// Bulk read request
+// Files within memfs are read in the order of their data in the image, so that
+// the files that share a block are read one after another and the block is decompressed once
+struct bulk_read_request {
+  std::string path;
+  std::string host_path;  // not empty if the file shall be read from the host filesystem
+  tebako_ino_t inode{0};
+  off_t size{0};
+  uint32_t fs_index{0};
+  uint32_t data_rank{memfs::no_data_rank};
+  int err{0};
+};
+
+void resolve_bulk_read_request(bulk_read_request& r)
+{
+  tebako_small_path t_path;
+  const char* p_path = to_tebako_path(t_path, r.path.c_str());
+  if (p_path == NULL) {
+    r.host_path = r.path;
+    return;
+  }
+
+  struct stat st;
+  std::string lnk;
+  int ret = dwarfs_stat(p_path, &st, lnk, true);
+  if (ret == DWARFS_S_LINK_OUTSIDE) {
+    r.host_path = lnk;
+  }
+  else if (ret != DWARFS_IO_CONTINUE) {
+    r.err = errno;
+  }
+  else if (S_ISDIR(st.st_mode)) {
+    r.err = EISDIR;
+  }
+  else {
+    r.inode = st.st_ino;
+    r.size = st.st_size;
+    r.fs_index = sync_tebako_memfs_table::getFsIndex(st.st_ino);
+    auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(r.fs_index);
+    if (fs != nullptr && fs->ensure_loaded() == DWARFS_IO_CONTINUE) {
+      r.data_rank = fs->inode_data_rank(st.st_ino);
+    }
+  }
+}
+
+int read_host_file(const std::string& path, std::vector<char>& buffer)
+{
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    return errno != 0 ? errno : ENOENT;
+  }
+  std::streamsize size = in.tellg();
+  in.seekg(0, std::ios::beg);
+  buffer.resize(static_cast<size_t>(size));
+  if (size > 0 && !in.read(buffer.data(), size)) {
+    return errno != 0 ? errno : EIO;
+  }
+  return 0;
+}
+
+int read_memfs_file(const bulk_read_request& r, std::vector<char>& buffer)
+{
+  buffer.resize(static_cast<size_t>(r.size));
+  off_t offset = 0;
+  while (offset < r.size) {
+    ssize_t n = dwarfs_inode_read(r.inode, buffer.data() + offset, static_cast<size_t>(r.size - offset), offset);
+    if (n <= 0) {
+      return n < 0 ? errno : EIO;
+    }
+    offset += n;
+  }
+  return 0;
+}
+
+int read_many(std::vector<bulk_read_request>& requests, tebako_read_cb cb, void* ctx)
+{
+  for (auto& r : requests) {
+    resolve_bulk_read_request(r);
+  }
+
+  std::stable_sort(requests.begin(), requests.end(), [](const bulk_read_request& a, const bulk_read_request& b) {
+    return std::tie(a.fs_index, a.data_rank) < std::tie(b.fs_index, b.data_rank);
+  });
+
+  int delivered = 0;
+  std::vector<char> buffer;
+  for (auto& r : requests) {
+    int err = r.err;
+    if (err == 0) {
+      errno = 0;
+      err = r.host_path.empty() ? read_memfs_file(r, buffer) : read_host_file(r.host_path, buffer);
+    }
+    if (err == 0) {
+      cb(r.path.c_str(), buffer.data(), buffer.size(), 0, ctx);
+      ++delivered;
+    }
+    else {
+      cb(r.path.c_str(), NULL, 0, err, ctx);
+    }
+  }
+  return delivered;
+}
+
+}  // namespace
+
+// tebako_read_many
+//  Reads n files and passes the content of each file to the callback as soon as it is read
+//  The callback is called once for each path; on failure data is NULL and err is errno value
+//  The order of callback calls is the order of file data in memfs image, not the order of paths
+//
+// returns
+//  the number of files read successfully
+//  -1 - error [errno is set]
+int tebako_read_many(const char* const* paths, size_t n, tebako_read_cb cb, void* ctx)
+{
+  if ((paths == NULL && n != 0) || cb == NULL) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+
+  try {
+    std::vector<bulk_read_request> requests(n);
+    for (size_t i = 0; i < n; ++i) {
+      if (paths[i] == NULL) {
+        TEBAKO_SET_LAST_ERROR(EFAULT);
+        return -1;
+      }
+      requests[i].path = paths[i];
+    }
+    return read_many(requests, cb, ctx);
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+}
+
+// tebako_read_dir_files
+//  Reads the files in the folder (not recursive) accepted by the filter [NULL filter accepts all files]
+//  Subfolders are skipped, see tebako_read_many for callback details
+//
+// returns
+//  the number of files read successfully
+//  -1 - error [errno is set]
+int tebako_read_dir_files(const char* dir, tebako_name_filter filter, void* filter_ctx, tebako_read_cb cb, void* ctx)
+{
+  if (dir == NULL || cb == NULL) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+
+  try {
+    std::vector<bulk_read_request> requests;
+    auto add_request = [&](const std::string& name) {
+      if (filter == NULL || filter(name.c_str(), filter_ctx)) {
+        bulk_read_request r;
+        r.path = (stdfs::path(dir) / name).string();
+        requests.push_back(std::move(r));
+      }
+    };
+
+    tebako_small_path t_path;
+    const char* p_path = to_tebako_path(t_path, dir);
+    if (p_path == NULL) {
+      std::error_code ec;
+      for (auto it = stdfs::directory_iterator(dir, ec); !ec && it != stdfs::directory_iterator(); it.increment(ec)) {
+        if (!it->is_directory(ec)) {
+          add_request(it->path().filename().string());
+        }
+      }
+      if (ec) {
+        TEBAKO_SET_LAST_ERROR(ec.value());
+        return -1;
+      }
+    }
+    else {
+      struct stat st;
+      std::string lnk;
+      std::vector<memfs_tree_entry> entries;
+      int ret = dwarfs_stat(p_path, &st, lnk, true);
+      if (ret == DWARFS_S_LINK_OUTSIDE) {
+        return tebako_read_dir_files(lnk.c_str(), filter, filter_ctx, cb, ctx);
+      }
+      if (ret == DWARFS_IO_CONTINUE) {
+        ret = inode_memfs_call(&memfs::list_dir, st.st_ino, entries);
+      }
+      if (ret != DWARFS_IO_CONTINUE) {
+        return -1;
+      }
+      for (const auto& e : entries) {
+        if (!S_ISDIR(e.st.st_mode)) {
+          add_request(e.path);
+        }
+      }
+    }
+    return read_many(requests, cb, ctx);
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+}
@@ -30,6 +30,7 @@
 #include <tebako-pch.h>
 #include <tebako-pch-pp.h>
 #include <tebako-common.h>
+#include <tebako-io.h>
 #include <tebako-io-inner.h>
 #include <tebako-io-root.h>
 #include <tebako-memfs.h>
@@ -55,13 +56,20 @@ void cmdline_args::build_arguments(const char* fs_mount_point, const char* fs_en
 }
 
 // build_arguments_for_extract
-//  Builds command line arguments to process --tebako-extract
+//  Processes --tebako-extract
+//  If fs_mount_point is within memfs, the files are extracted by tebako_extract and Ruby gets an empty script.
+//  Otherwise builds command line arguments that copy the files with Ruby:
 //  ruby -e "require 'fileutils'; FileUtils.copy_entry '<tebako::fs_mount_point>',argv[2] || 'source_filesystem'"
 void cmdline_args::build_arguments_for_extract(const char* fs_mount_point)
 {
-  std::string cmd =
-      std::string("require 'fileutils'; FileUtils.copy_entry '") + fs_mount_point + "', '" + extract_folder + "'";
   printf("Extracting tebako image to '%s' \n", extract_folder.c_str());
+  std::string cmd;
+  if (tebako_extract(fs_mount_point, extract_folder.c_str(), 0) != 0) {
+    if (errno != EINVAL) {
+      throw std::runtime_error("Failed to extract tebako image to '" + extract_folder + "': " + strerror(errno));
+    }
+    cmd = std::string("require 'fileutils'; FileUtils.copy_entry '") + fs_mount_point + "', '" + extract_folder + "'";
+  }
   size_t new_argv_size = 3 + cmd.size() + 1 + strlen(argv[0]) + 1;
   new_argv = new char*[3];
   char* argv_memory = new_argv_memory = new char[new_argv_size];
@@ -252,69 +260,199 @@ void cmdline_args::parse_arguments(void)
   }
 }
 
-void cmdline_args::process_mountpoints()
+namespace {
+// Filesystem image referenced by "--tebako-mount" argument
+struct mount_image {
+  std::string target;
+  std::shared_ptr<memfs> fs;
+  std::string error;  // filesystem image load error
+};
+
+// Mount rule parsed from "--tebako-mount" argument
+//  <path>:<host folder>
+//  <path>><filesystem image>
+// The filesystem image is the rest of the argument, so its path may contain ':' or '>'.
+// Several '>' rules with the same path make an overlay, the first rule is the bottom layer
+struct mount_rule {
+  char separator;
+  std::string path;      // parent folder of the mount point within memfs
+  std::string filename;  // mount point name
+  std::string target;
+
+  std::vector<mount_image> images;  // filesystem images of '>' rule, bottom layer first
+};
+}  // namespace
+
+static mount_rule parse_mount_rule(const std::string& item)
 {
-  for (const auto& item : mountpoints) {
-    // Split item by the first ':' or '>'
-    size_t separator_pos = item.find_first_of(":>");
-    if (separator_pos != std::string::npos) {
-      char separator = item[separator_pos];
-      // Extract the first and second parts
-      std::string mountpoint = item.substr(0, separator_pos);
-      std::string target = item.substr(separator_pos + 1);
-
-      // Split file_path into path and filename
-      stdfs::path p(mountpoint);
-
-      if (p.is_absolute()) {
-        throw std::invalid_argument("Path " + mountpoint + " is not within tebako memfs");
-      }
+  // Split item by the first ':' or '>'
+  size_t separator_pos = item.find_first_of(":>");
+  if (separator_pos == std::string::npos) {
+    throw std::invalid_argument("Invalid input: missing ':' or '>' separator in " + item);
+  }
 
-      std::string path = p.parent_path().string();
-      std::string filename = p.filename().string();
+  mount_rule rule;
+  rule.separator = item[separator_pos];
+  // Extract the first and second parts
+  std::string mountpoint = item.substr(0, separator_pos);
+  rule.target = item.substr(separator_pos + 1);
 
-      // Check that both filename and target are not empty
-      if (filename.empty() || target.empty()) {
-        throw std::invalid_argument("Invalid input: path or filename or target is empty in " + item);
-      }
+  // Split file_path into path and filename
+  stdfs::path p(mountpoint);
 
-      struct stat st;
-      std::string lnk;
-      uint32_t root = sync_tebako_memfs_table::get_tebako_memfs_table().get(0)->get_root_inode();
-      int res = dwarfs_inode_relative_stat(root, path, &st, lnk, false);
-      if (res == DWARFS_IO_ERROR) {
-        throw std::invalid_argument("Path " + path + " does not exist or is not accessible");
-      }
-      if (res == DWARFS_S_LINK_OUTSIDE) {
-        throw std::invalid_argument("Path " + path + " is not within tebako memfs");
-      }
+  if (p.is_absolute()) {
+    throw std::invalid_argument("Path " + mountpoint + " is not within tebako memfs");
+  }
 
-      if (separator == ':') {
-        sync_tebako_mount_table::get_tebako_mount_table().insert(st.st_ino, filename, target);
-      }
-      else {  // assume that  (separator == '>')
-        std::ifstream file(target, std::ios::binary | std::ios::ate);
-        if (!file) {
-          throw std::invalid_argument("Path " + target + " does not exist");
-        }
-        size_t size = file.tellg();
-        file.seekg(0, std::ios::beg);
+  rule.path = p.parent_path().string();
+  rule.filename = p.filename().string();
 
-        std::vector<char> buffer;
-        buffer.resize(size);
+  // Check that both filename and target are not empty
+  if (rule.filename.empty() || rule.target.empty()) {
+    throw std::invalid_argument("Invalid input: path or filename or target is empty in " + item);
+  }
 
-        if (!file.read(buffer.data(), size)) {
-          throw std::invalid_argument("Failed to load filesystem image from " + target);
-        }
+  if (rule.separator == '>') {
+    rule.images.push_back(mount_image{rule.target, nullptr, std::string()});
+  }
+  return rule;
+}
 
-        int ret = mount_memfs(buffer.data(), size, "auto", st.st_ino, filename.c_str());
-        if (ret < 1) {
-          throw std::invalid_argument("Failed to mount filesystem image from " + target);
-        }
+static size_t mount_rule_depth(const mount_rule& rule)
+{
+  stdfs::path p(rule.path);
+  return std::distance(p.begin(), p.end());
+}
+
+// load_mount_image
+//  Reads filesystem image and loads memfs (or defers loading if lazy mount is enabled)
+//  This function is executed by mount workers, errors are reported via image.error
+static void load_mount_image(mount_image& image) noexcept
+{
+  try {
+    std::ifstream file(image.target, std::ios::binary | std::ios::ate);
+    if (!file) {
+      image.error = "Path " + image.target + " does not exist";
+      return;
+    }
+    size_t size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    std::vector<char> buffer;
+    buffer.resize(size);
+
+    if (!file.read(buffer.data(), size)) {
+      image.error = "Failed to load filesystem image from " + image.target;
+      return;
+    }
+
+    auto fs = std::make_shared<memfs>(std::move(buffer));
+    if (memfs::options().lazy_mount) {
+      fs->defer_load("auto");
+    }
+    else if (fs->load("auto") != 0) {
+      image.error = "Failed to mount filesystem image from " + image.target;
+      return;
+    }
+    image.fs = std::move(fs);
+  }
+  catch (...) {
+    image.error = "Failed to load filesystem image from " + image.target;
+  }
+}
+
+// load_mount_images
+//  Loads independent filesystem images on a small pool of threads
+static void load_mount_images(std::vector<mount_image*>& images)
+{
+  const size_t max_workers = 4;
+  size_t n_workers = std::min({images.size(), max_workers, static_cast<size_t>(std::thread::hardware_concurrency())});
+
+  std::atomic<size_t> next{0};
+  auto worker = [&images, &next]() {
+    for (size_t i = next++; i < images.size(); i = next++) {
+      load_mount_image(*images[i]);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  if (n_workers > 1) {
+    try {
+      for (size_t i = 1; i < n_workers; ++i) {  // This thread is a worker as well
+        workers.emplace_back(worker);
       }
     }
+    catch (...) {
+      // Could not start a thread; the images are loaded by running workers and by this thread
+    }
+  }
+  worker();
+  for (auto& w : workers) {
+    w.join();
+  }
+}
+
+// cmdline_args::process_mountpoints
+//  (1) parses all mount rules
+//  (2) reads and loads filesystem images in parallel
+//  (3) publishes mount points in dependency order, i.e. the rule that mounts into the folder
+//      of another mounted image is processed after that image is mounted
+void cmdline_args::process_mountpoints()
+{
+  std::vector<mount_rule> rules;
+  for (const auto& item : mountpoints) {
+    mount_rule rule = parse_mount_rule(item);
+    auto layer_of = std::find_if(rules.begin(), rules.end(), [&rule](const mount_rule& r) {
+      return r.separator == '>' && rule.separator == '>' && r.path == rule.path && r.filename == rule.filename;
+    });
+    if (layer_of != rules.end()) {
+      layer_of->target += ", " + rule.target;
+      layer_of->images.push_back(std::move(rule.images.front()));
+    }
     else {
-      throw std::invalid_argument("Invalid input: missing ':' or '>' separator in " + item);
+      rules.push_back(std::move(rule));
+    }
+  }
+  std::stable_sort(rules.begin(), rules.end(), [](const mount_rule& a, const mount_rule& b) {
+    return mount_rule_depth(a) < mount_rule_depth(b);
+  });
+
+  std::vector<mount_image*> images;
+  for (auto& rule : rules) {
+    for (auto& image : rule.images) {
+      images.push_back(&image);
+    }
+  }
+  load_mount_images(images);
+
+  for (auto& rule : rules) {
+    struct stat st;
+    std::string lnk;
+    tebako_ino_t root = sync_tebako_memfs_table::get_tebako_memfs_table().get(0)->get_root_inode();
+    int res = dwarfs_inode_relative_stat(root, rule.path, &st, lnk, false);
+    if (res == DWARFS_IO_ERROR) {
+      throw std::invalid_argument("Path " + rule.path + " does not exist or is not accessible");
+    }
+    if (res == DWARFS_S_LINK_OUTSIDE) {
+      throw std::invalid_argument("Path " + rule.path + " is not within tebako memfs");
+    }
+
+    if (rule.separator == ':') {
+      sync_tebako_mount_table::get_tebako_mount_table().insert(st.st_ino, rule.filename, rule.target);
+    }
+    else {  // assume that  (separator == '>')
+      std::vector<std::shared_ptr<memfs>> layers;
+      for (auto& image : rule.images) {
+        if (!image.error.empty()) {
+          throw std::invalid_argument(image.error);
+        }
+        layers.push_back(image.fs);
+      }
+      int ret = layers.size() == 1 ? mount_memfs(layers.front(), st.st_ino, rule.filename.c_str())
+                                   : mount_memfs_overlay(layers, st.st_ino, rule.filename.c_str());
+      if (ret < 1) {
+        throw std::invalid_argument("Failed to mount filesystem image from " + rule.target);
+      }
     }
   }
 }
@@ -337,4 +475,17 @@ void cmdline_args::process_package()
   descriptor = package_descriptor(package);
 }
 
+// Starts background extraction of the shared objects listed by package descriptor
+// Shall be called after the package has been mounted
+void cmdline_args::process_dl_prefetch()
+{
+  if (descriptor && !descriptor->get_dl_prefetch().empty()) {
+    std::vector<const char*> paths;
+    for (const auto& dl : descriptor->get_dl_prefetch()) {
+      paths.push_back(dl.c_str());
+    }
+    tebako_dl_prefetch(paths.data(), paths.size());
+  }
+}
+
 }  // namespace tebako
@@ -40,6 +40,45 @@ using namespace std;
 
 namespace tebako {
 
+void fill_dirent(tebako_dirent& entry, const std::string& name, const struct stat& st, off_t offset) noexcept
+{
+#ifndef RB_W32
+  entry.e.d_ino = st.st_ino;
+#if __MACH__
+  entry.e.d_seekoff = offset;
+#else
+  entry.e.d_off = offset;
+#endif
+  entry.e.d_type = IFTODT(st.st_mode);
+  strncpy(entry._e.d_name, name.c_str(), TEBAKO_PATH_LENGTH);
+  entry._e.d_name[TEBAKO_PATH_LENGTH] = '\0';
+  entry.e.d_reclen = sizeof(entry);
+#else
+#ifdef _WIN32
+  entry.e.d_altname = 0;
+  entry.e.d_altlen = 0;
+  entry.e.d_name = entry.d_name;
+  if (S_ISDIR(st.st_mode)) {
+    entry.e.d_type = DT_DIR;
+  }
+  else if (S_ISLNK(st.st_mode)) {
+    entry.e.d_type = DT_LNK;
+  }
+  else {
+    entry.e.d_type = DT_REG;
+  }
+  entry.e.d_namlen = std::min(name.length(), TEBAKO_PATH_LENGTH - 1);
+#else
+  entry.e.d_reclen = 0;
+  entry.e.d_namlen = std::min(name.length(), sizeof(entry.e.d_name) - 1);
+#endif
+  static int dummy = INT_MAX;
+  entry.e.d_ino = dummy--;
+  strncpy(entry.e.d_name, name.c_str(), entry.e.d_namlen);
+  entry.e.d_name[entry.e.d_namlen] = '\0';
+#endif
+}
+
 sync_tebako_dstable& sync_tebako_dstable::get_tebako_dstable(void)
 {
   static sync_tebako_dstable ds_table{};
@@ -0,0 +1,269 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+
+#include <folly/hash/Checksum.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+
+#include <tebako-disk-cache.h>
+
+namespace tebako {
+
+namespace {
+
+struct disk_cache_header {
+  char magic[8];
+  uint64_t size;
+  uint32_t crc;
+  uint32_t reserved;
+};
+
+constexpr char disk_cache_magic[8] = {'T', 'B', 'K', 'D', 'C', '0', '1', '\0'};
+
+}  // namespace
+
+disk_cache_entry::~disk_cache_entry()
+{
+  if (map_ != nullptr) {
+    ::munmap(map_, map_size_);
+  }
+}
+
+// disk_cache::image_id
+//  Image id is the image size and 128-bit hash of the whole image
+//  It is computed once, when the cache is created at mount
+std::string disk_cache::image_id(const void* image, size_t image_size)
+{
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  folly::hash::SpookyHashV2::Hash128(image, image_size, &h1, &h2);
+
+  std::ostringstream id;
+  id << std::hex << std::setfill('0') << std::setw(16) << static_cast<uint64_t>(image_size) << '-' << std::setw(16)
+     << h1 << std::setw(16) << h2;
+  return id.str();
+}
+
+disk_cache::disk_cache(const std::string& root,
+                       const void* image,
+                       size_t image_size,
+                       size_t max_entry_size,
+                       size_t max_mapped_entries)
+    : directory_((stdfs::path(root) / image_id(image, image_size)).string()),
+      max_entry_size_(max_entry_size),
+      max_mapped_entries_(std::max<size_t>(max_mapped_entries, 1))
+{
+  std::error_code ec;
+  stdfs::create_directories(directory_, ec);
+  directory_ok_ = !ec;
+}
+
+std::string disk_cache::entry_path(uint32_t inode) const
+{
+  return (stdfs::path(directory_) / std::to_string(inode)).string();
+}
+
+// disk_cache::map_entry
+//  Maps cache file and verifies its integrity
+//  Returns nullptr if there is no such file or the file is damaged
+std::shared_ptr<const disk_cache_entry> disk_cache::map_entry(uint32_t inode)
+{
+  int flags = O_RDONLY;
+#ifdef O_BINARY
+  flags |= O_BINARY;
+#endif
+  int fd = ::open(entry_path(inode).c_str(), flags);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  void* map = MAP_FAILED;
+  size_t map_size = 0;
+  if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) > sizeof(disk_cache_header)) {
+    map_size = static_cast<size_t>(st.st_size);
+    map = ::mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto entry = std::make_shared<disk_cache_entry>(map, map_size, static_cast<const char*>(map) + sizeof(disk_cache_header),
+                                                  map_size - sizeof(disk_cache_header));
+  disk_cache_header header;
+  memcpy(&header, map, sizeof(header));
+  if (memcmp(header.magic, disk_cache_magic, sizeof(header.magic)) != 0 || header.size != entry->size() ||
+      header.crc != folly::crc32c(reinterpret_cast<const uint8_t*>(entry->data()), entry->size())) {
+    return nullptr;
+  }
+  return entry;
+}
+
+std::shared_ptr<const disk_cache_entry> disk_cache::get(uint32_t inode, bool& cacheable) noexcept
+{
+  cacheable = directory_ok_;
+  if (!cacheable) {
+    return nullptr;
+  }
+
+  try {
+    {
+      auto locked = entries_.rlock();
+      auto it = locked->entries.find(inode);
+      if (it != locked->entries.end()) {
+        cacheable = (it->second != nullptr);
+        if (it->second) {
+          it->second->touch();
+        }
+        return it->second;
+      }
+    }
+
+    auto entry = map_entry(inode);
+    if (entry) {
+      entry = insert(inode, std::move(entry));
+    }
+    return entry;
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+
+std::shared_ptr<const disk_cache_entry> disk_cache::put(uint32_t inode, const void* data, size_t size) noexcept
+{
+  if (!directory_ok_ || size == 0 || size > max_entry_size_) {
+    reject(inode);
+    return nullptr;
+  }
+
+  try {
+    disk_cache_header header{};
+    memcpy(header.magic, disk_cache_magic, sizeof(header.magic));
+    header.size = size;
+    header.crc = folly::crc32c(static_cast<const uint8_t*>(data), size);
+
+    // Another process may populate the same entry concurrently; rename replaces
+    // the file atomically so that the readers always see complete content
+    std::string path = entry_path(inode);
+    std::ostringstream tmp;
+    tmp << path << ".tmp." << ::getpid() << '.' << std::hash<std::thread::id>{}(std::this_thread::get_id());
+    {
+      std::ofstream out(tmp.str(), std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.write(static_cast<const char*>(data), size);
+      out.close();
+      if (!out) {
+        std::error_code ec;
+        stdfs::remove(tmp.str(), ec);
+        reject(inode);
+        return nullptr;
+      }
+    }
+
+    std::error_code ec;
+    stdfs::rename(tmp.str(), path, ec);
+    if (ec) {
+      stdfs::remove(tmp.str(), ec);
+      reject(inode);
+      return nullptr;
+    }
+
+    auto entry = map_entry(inode);
+    if (!entry) {
+      reject(inode);
+      return nullptr;
+    }
+    return insert(inode, std::move(entry));
+  }
+  catch (...) {
+    reject(inode);
+    return nullptr;
+  }
+}
+
+// disk_cache::insert
+//  Publishes mapped entry
+//  The number of mappings is bounded, so that a process with many cached files does not exhaust
+//  vm.max_map_count. Victims are selected by CLOCK: an entry that has been read since the previous
+//  pass gets a second chance. An evicted entry is unmapped when its last reader releases it and is
+//  mapped again on the next access.
+std::shared_ptr<const disk_cache_entry> disk_cache::insert(uint32_t inode,
+                                                           std::shared_ptr<const disk_cache_entry> entry)
+{
+  auto locked = entries_.wlock();
+  auto ins = locked->entries.emplace(inode, entry);
+  if (!ins.second) {
+    return ins.first->second;
+  }
+
+  locked->clock.push_back(inode);
+  while (locked->clock.size() > max_mapped_entries_) {
+    uint32_t victim = locked->clock.front();
+    locked->clock.pop_front();
+    auto it = locked->entries.find(victim);
+    if (it == locked->entries.end() || it->second == nullptr) {
+      continue;
+    }
+    if (victim != inode && it->second->test_and_clear_referenced()) {
+      locked->clock.push_back(victim);
+    }
+    else if (victim != inode) {
+      locked->entries.erase(it);
+    }
+    else {
+      locked->clock.push_back(victim);  // Never evict the entry that is being inserted
+    }
+  }
+  return entry;
+}
+
+size_t disk_cache::mapped_entries() const
+{
+  return entries_.rlock()->clock.size();
+}
+
+void disk_cache::reject(uint32_t inode) noexcept
+{
+  try {
+    entries_.wlock()->entries.emplace(inode, nullptr);
+  }
+  catch (...) {
+    // The file will be tried again
+  }
+}
+
+}  // namespace tebako
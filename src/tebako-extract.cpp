@@ -0,0 +1,262 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-dirent.h>
+#include <tebako-memfs.h>
+#include <tebako-io.h>
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs-table.h>
+
+#include <utime.h>
+
+using namespace tebako;
+
+namespace {
+
+// Extraction job
+// Directories are created in tree order, then regular files are written by a pool
+// of workers in the order of their data in the image, then symlinks are created and
+// directory permissions are restored (deepest first)
+class tebako_extractor {
+ private:
+  static constexpr size_t buffer_size = static_cast<size_t>(4) << 20;
+  static constexpr size_t max_workers = 8;
+
+  std::vector<memfs_tree_entry> entries;
+  stdfs::path dest;
+  int options;
+
+  std::atomic<size_t> next_file{0};
+  std::vector<size_t> files;  // indices of regular files in entries, in data order
+
+  std::atomic<int> error{0};
+
+  void set_error(int err)
+  {
+    int expected = 0;
+    error.compare_exchange_strong(expected, err != 0 ? err : EIO);
+  }
+
+  stdfs::path target(const memfs_tree_entry& e) const { return e.path.empty() ? dest : dest / stdfs::path(e.path); }
+
+  bool is_unchanged(const memfs_tree_entry& e, const stdfs::path& p) const
+  {
+    struct stat st;
+    return ::stat(p.string().c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_size == e.st.st_size &&
+           st.st_mtime == e.st.st_mtime;
+  }
+
+  void set_times(const memfs_tree_entry& e, const stdfs::path& p)
+  {
+    struct utimbuf times;
+    times.actime = e.st.st_atime;
+    times.modtime = e.st.st_mtime;
+    ::utime(p.string().c_str(), &times);
+  }
+
+  void set_permissions(const memfs_tree_entry& e, const stdfs::path& p)
+  {
+    std::error_code ec;
+    stdfs::permissions(p, static_cast<stdfs::perms>(e.st.st_mode & 0777), ec);
+  }
+
+  void write_file(const memfs_tree_entry& e, std::vector<char>& buffer)
+  {
+    stdfs::path p = target(e);
+    if ((options & TEBAKO_EXTRACT_SKIP_UNCHANGED) && is_unchanged(e, p)) {
+      return;
+    }
+
+    std::error_code ec;
+    stdfs::remove(p, ec);  // A read-only file or a symlink may be there
+    std::ofstream out(p, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      set_error(errno);
+      return;
+    }
+
+    off_t offset = 0;
+    while (offset < e.st.st_size) {
+      size_t chunk = std::min(buffer.size(), static_cast<size_t>(e.st.st_size - offset));
+      ssize_t n = dwarfs_inode_read(e.st.st_ino, buffer.data(), chunk, offset);
+      if (n <= 0) {
+        set_error(n < 0 ? errno : EIO);
+        return;
+      }
+      if (!out.write(buffer.data(), n)) {
+        set_error(errno);
+        return;
+      }
+      offset += n;
+    }
+    out.close();
+    if (!out) {
+      set_error(errno);
+      return;
+    }
+    set_permissions(e, p);
+    set_times(e, p);
+  }
+
+  void worker(void)
+  {
+    try {
+      std::vector<char> buffer(buffer_size);
+      for (size_t i = next_file++; i < files.size(); i = next_file++) {
+        write_file(entries[files[i]], buffer);
+      }
+    }
+    catch (...) {
+      set_error(ENOMEM);
+    }
+  }
+
+ public:
+  tebako_extractor(const char* dest, int options) : dest(dest), options(options) {}
+
+  int list(tebako_ino_t inode) { return inode_memfs_call(&memfs::list_tree, inode, entries); }
+
+  int extract(void)
+  {
+    std::error_code ec;
+    // (1) directories
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const auto& e = entries[i];
+      if (S_ISDIR(e.st.st_mode)) {
+        stdfs::create_directories(target(e), ec);
+        if (ec) {
+          set_error(ec.value());
+          break;
+        }
+      }
+      else if (S_ISREG(e.st.st_mode)) {
+        files.push_back(i);
+      }
+    }
+
+    // (2) regular files
+    if (error == 0) {
+      std::stable_sort(files.begin(), files.end(),
+                       [this](size_t a, size_t b) { return entries[a].data_rank < entries[b].data_rank; });
+
+      size_t n_workers = std::min({files.size(), max_workers, static_cast<size_t>(std::thread::hardware_concurrency())});
+      std::vector<std::thread> workers;
+      try {
+        for (size_t i = 1; i < n_workers; ++i) {  // This thread is a worker as well
+          workers.emplace_back(&tebako_extractor::worker, this);
+        }
+      }
+      catch (...) {
+        // Could not start a thread; the files are written by running workers and by this thread
+      }
+      worker();
+      for (auto& w : workers) {
+        w.join();
+      }
+    }
+
+    // (3) symlinks
+    for (const auto& e : entries) {
+      if (error == 0 && S_ISLNK(e.st.st_mode)) {
+        stdfs::path p = target(e);
+        stdfs::remove(p, ec);
+        stdfs::create_symlink(e.link, p, ec);
+        if (ec) {
+          set_error(ec.value());
+        }
+      }
+    }
+
+    // (4) directory permissions and times, deepest first
+    for (auto e = entries.rbegin(); e != entries.rend(); ++e) {
+      if (S_ISDIR(e->st.st_mode)) {
+        stdfs::path p = target(*e);
+        set_permissions(*e, p);
+        set_times(*e, p);
+      }
+    }
+
+    if (error != 0) {
+      TEBAKO_SET_LAST_ERROR(error);
+      return DWARFS_IO_ERROR;
+    }
+    return DWARFS_IO_CONTINUE;
+  }
+};
+
+}  // namespace
+
+// tebako_extract
+//  Extracts memfs file or folder (src) to the host filesystem (dest)
+//  dest is created if it does not exist; nested mount points are not followed
+//
+// returns
+//  0 - success
+//  -1 - error [errno is set]
+int tebako_extract(const char* src, const char* dest, int options)
+{
+  int ret = -1;
+  if (src == NULL || dest == NULL) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return ret;
+  }
+
+  try {
+    std::string lnk;
+    tebako_small_path t_path;
+    const char* p_path = to_tebako_path(t_path, src);
+    if (p_path == NULL) {
+      TEBAKO_SET_LAST_ERROR(EINVAL);  // Not within memfs
+    }
+    else {
+      struct stat st;
+      ret = dwarfs_stat(p_path, &st, lnk, true);
+      if (ret == DWARFS_S_LINK_OUTSIDE) {
+        TEBAKO_SET_LAST_ERROR(EINVAL);
+        ret = -1;
+      }
+      else if (ret == DWARFS_IO_CONTINUE) {
+        tebako_extractor extractor(dest, options);
+        ret = extractor.list(st.st_ino);
+        if (ret == DWARFS_IO_CONTINUE) {
+          ret = extractor.extract();
+        }
+      }
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = -1;
+  }
+  return ret < 0 ? -1 : 0;
+}
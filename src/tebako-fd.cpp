@@ -35,6 +35,8 @@
 #include <tebako-io-root.h>
 #include <tebako-fd.h>
 #include <tebako-memfs.h>
+#include <tebako-memfs-overlay.h>
+#include <tebako-mount-table.h>
 
 using namespace std;
 
@@ -46,6 +48,60 @@ sync_tebako_fdtable& sync_tebako_fdtable::get_tebako_fdtable(void)
   return fd_table;
 }
 
+// sync_tebako_fdtable::insert
+//  Checks open flags against the stat of memfs file and allocates a descriptor for it
+//
+// returns
+//  descriptor - success
+//  DWARFS_IO_ERROR - error [errno is set]
+
+int sync_tebako_fdtable::insert(std::shared_ptr<tebako_fd> fd, int flags) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  // [EROFS] The named file resides on a read - only file system and either
+  // O_WRONLY, O_RDWR, O_CREAT(if the file does not exist), or O_TRUNC is set
+  // in the oflag argument.
+  if (flags & (O_RDWR | O_WRONLY | O_TRUNC | O_CREAT)) {
+    TEBAKO_SET_LAST_ERROR(EROFS);
+  }
+  else if (!S_ISDIR(fd->st.st_mode) && (flags & O_DIRECTORY)) {
+    // [ENOTDIR] ... or O_DIRECTORY was specified and the path argument
+    // resolves to a non - directory file.
+    TEBAKO_SET_LAST_ERROR(ENOTDIR);
+  }
+  else if (S_ISLNK(fd->st.st_mode) && (flags & O_NOFOLLOW)) {
+    // [O_NOFOLLOW] If the trailing component (i.e., basename) of
+    // pathname is a symbolic link, then the open fails, with the
+    // error ELOOP.
+    TEBAKO_SET_LAST_ERROR(ELOOP);
+  }
+  else {
+    try {
+      fd->handle = new int;
+      // get a dummy fd from the system
+      ret = ::dup(0);
+      if (ret == DWARFS_IO_ERROR) {
+        // [EMFILE]  All file descriptors available to the process are
+        // currently open.
+        TEBAKO_SET_LAST_ERROR(EMFILE);
+      }
+      else {
+        // construct a handle (mainly) for win32
+        *fd->handle = ret;
+        (*s_tebako_fdtable.wlock())[ret] = std::move(fd);
+      }
+    }
+    catch (bad_alloc&) {
+      if (ret > 0) {
+        ::close(ret);
+        ret = DWARFS_IO_ERROR;
+      }
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+    }
+  }
+  return ret;
+}
+
 int sync_tebako_fdtable::open(const char* path, int flags, std::string& lnk) noexcept
 {
   int ret = DWARFS_IO_ERROR;
@@ -53,43 +109,7 @@ int sync_tebako_fdtable::open(const char* path, int flags, std::string& lnk) noe
     auto fd = make_shared<tebako_fd>();
     switch (dwarfs_stat(path, &fd->st, lnk, (flags & O_NOFOLLOW) == 0)) {
       case DWARFS_IO_CONTINUE:
-        // [EROFS] The named file resides on a read - only file system and either
-        // O_WRONLY, O_RDWR, O_CREAT(if the file does not exist), or O_TRUNC is set
-        // in the oflag argument.
-        if (flags & (O_RDWR | O_WRONLY | O_TRUNC | O_CREAT)) {
-          TEBAKO_SET_LAST_ERROR(EROFS);
-        }
-        else if (!S_ISDIR(fd->st.st_mode) && (flags & O_DIRECTORY)) {
-          // [ENOTDIR] ... or O_DIRECTORY was specified and the path argument
-          // resolves to a non - directory file.
-          TEBAKO_SET_LAST_ERROR(ENOTDIR);
-        }
-        else if (S_ISLNK(fd->st.st_mode) && (flags & O_NOFOLLOW)) {
-          // [O_NOFOLLOW] If the trailing component (i.e., basename) of
-          // pathname is a symbolic link, then the open fails, with the
-          // error ELOOP.
-          TEBAKO_SET_LAST_ERROR(ELOOP);
-        }
-        else {
-          fd->handle = new int;
-          if (fd->handle == NULL) {
-            TEBAKO_SET_LAST_ERROR(ENOMEM);
-          }
-          else {
-            // get a dummy fd from the system
-            ret = ::dup(0);
-            if (ret == DWARFS_IO_ERROR) {
-              // [EMFILE]  All file descriptors available to the process are
-              // currently open.
-              TEBAKO_SET_LAST_ERROR(EMFILE);
-            }
-            else {
-              // construct a handle (mainly) for win32
-              *fd->handle = ret;
-              (*s_tebako_fdtable.wlock())[ret] = std::move(fd);
-            }
-          }
-        }
+        ret = insert(std::move(fd), flags);
         break;
       case DWARFS_S_LINK_OUTSIDE:
         ret = DWARFS_S_LINK_OUTSIDE;
@@ -109,16 +129,38 @@ int sync_tebako_fdtable::open(const char* path, int flags, std::string& lnk) noe
     }
   }
   catch (bad_alloc&) {
-    if (ret > 0) {
-      ::close(ret);
-      ret = DWARFS_IO_ERROR;
-    }
     TEBAKO_SET_LAST_ERROR(ENOMEM);
   }
 
   return ret;
 }
 
+// sync_tebako_fdtable::open_inode
+//  Opens memfs file by its composite inode without path resolution
+//
+// returns
+//  descriptor - success
+//  DWARFS_IO_ERROR - error [errno is set]
+
+int sync_tebako_fdtable::open_inode(tebako_ino_t inode, int flags) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  try {
+    auto fd = make_shared<tebako_fd>();
+    std::string lnk;
+    if (dwarfs_inode_relative_stat(inode, "", &fd->st, lnk, true) == DWARFS_IO_CONTINUE) {
+      ret = insert(std::move(fd), flags);
+    }
+    else {
+      TEBAKO_SET_LAST_ERROR((flags & (O_RDWR | O_WRONLY | O_TRUNC | O_CREAT)) ? EROFS : ESTALE);
+    }
+  }
+  catch (bad_alloc&) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
 int sync_tebako_fdtable::openat(int vfd, const char* path, int flags, std::string& lnk) noexcept
 {
   struct stat stfd;
@@ -144,43 +186,7 @@ int sync_tebako_fdtable::openat(int vfd, const char* path, int flags, std::strin
           auto fd = make_shared<tebako_fd>();
           switch (dwarfs_inode_relative_stat(stfd.st_ino, path, &fd->st, lnk, (flags & O_NOFOLLOW) == 0)) {
             case DWARFS_IO_CONTINUE:
-              // [EROFS] The named file resides on a read - only file system and either
-              // O_WRONLY, O_RDWR, O_CREAT(if the file does not exist), or O_TRUNC is set
-              // in the oflag argument.
-              if (flags & (O_RDWR | O_WRONLY | O_TRUNC | O_CREAT)) {
-                TEBAKO_SET_LAST_ERROR(EROFS);
-              }
-              else if (!S_ISDIR(fd->st.st_mode) && (flags & O_DIRECTORY)) {
-                // [ENOTDIR] ... or O_DIRECTORY was specified and the path
-                // argument resolves to a non - directory file.
-                TEBAKO_SET_LAST_ERROR(ENOTDIR);
-              }
-              else if (S_ISLNK(fd->st.st_mode) && (flags & O_NOFOLLOW)) {
-                //    [O_NOFOLLOW] If the trailing component (i.e., basename) of
-                //    pathname is a symbolic link, then the open fails, with
-                //    the error ELOOP.
-                TEBAKO_SET_LAST_ERROR(ELOOP);
-              }
-              else {
-                fd->handle = new int;
-                if (fd->handle == NULL) {
-                  TEBAKO_SET_LAST_ERROR(ENOMEM);
-                }
-                else {
-                  // get a dummy fd from the system
-                  ret = ::dup(0);
-                  if (ret == DWARFS_IO_ERROR) {
-                    // [EMFILE]  All file descriptors available to the process
-                    // are currently open.
-                    TEBAKO_SET_LAST_ERROR(EMFILE);
-                  }
-                  else {
-                    // construct a handle (mainly) for win32
-                    *fd->handle = ret;
-                    (*s_tebako_fdtable.wlock())[ret] = std::move(fd);
-                  }
-                }
-              }
+              ret = insert(std::move(fd), flags);
               break;
             case DWARFS_S_LINK_OUTSIDE:
               ret = DWARFS_S_LINK_OUTSIDE;
@@ -199,10 +205,6 @@ int sync_tebako_fdtable::openat(int vfd, const char* path, int flags, std::strin
           }
         }
         catch (bad_alloc&) {
-          if (ret > 0) {
-            ::close(ret);
-            ret = DWARFS_IO_ERROR;
-          }
           TEBAKO_SET_LAST_ERROR(ENOMEM);
         }
       }
@@ -278,9 +280,13 @@ int sync_tebako_fdtable::readdir(int vfd,
 {
   auto p_fdtable = s_tebako_fdtable.rlock();
   auto p_fd = p_fdtable->find(vfd);
-  return (p_fd != p_fdtable->end())
-             ? dwarfs_inode_readdir(p_fd->second->st.st_ino, cache, cache_start, buffer_size, cache_size, dir_size)
-             : DWARFS_INVALID_FD;
+  if (p_fd == p_fdtable->end()) {
+    return DWARFS_INVALID_FD;
+  }
+  // Directory that exists in several layers of overlay mount lists the union of the layers
+  auto overlay = sync_tebako_mount_table::get_tebako_mount_table().get_merged_dir_overlay(p_fd->second->st.st_ino);
+  return overlay ? overlay->readdir(p_fd->second->st.st_ino, cache, cache_start, buffer_size, cache_size, dir_size)
+                 : dwarfs_inode_readdir(p_fd->second->st.st_ino, cache, cache_start, buffer_size, cache_size, dir_size);
 }
 
 #ifdef TEBAKO_HAS_READV
@@ -298,7 +304,7 @@ ssize_t sync_tebako_fdtable::readv(int vfd, const struct ::iovec* iov, int iovcn
     ret = DWARFS_IO_ERROR;
   }
   else {
-    uint32_t ino;
+    tebako_ino_t ino;
     off_t pos;
     auto p_fdtable = s_tebako_fdtable.rlock();
     auto p_fd = p_fdtable->find(vfd);
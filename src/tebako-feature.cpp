@@ -0,0 +1,239 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-dirent.h>
+#include <tebako-memfs.h>
+#include <tebako-io.h>
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs-table.h>
+#include <tebako-mount-table.h>
+
+using namespace tebako;
+
+namespace {
+
+// Load path entry, resolved once per memfs generation
+struct load_path_dir {
+  enum kind_t { memfs_dir, host_dir, no_dir };
+  kind_t kind;
+  tebako_ino_t ino;  // composite inode of memfs directory
+};
+
+// Resolved load path entries and features that were not found
+// Misses are keyed by the feature and the fingerprint of the load path; they are stored only if
+// every load path entry is within memfs, which does not change until the next mount or unmount
+struct feature_cache {
+  uint64_t memfs_generation{0};
+  uint64_t mount_generation{0};
+  std::unordered_map<std::string, load_path_dir> dirs;
+  std::unordered_set<std::string> misses;
+};
+
+folly::Synchronized<feature_cache> s_feature_cache;
+const size_t feature_cache_max_entries = 16384;
+
+// FNV-1a, the fingerprint of the load path and extension list
+uint64_t fingerprint_update(uint64_t h, const char* s)
+{
+  do {
+    h ^= static_cast<unsigned char>(*s);
+    h *= 0x100000001b3ULL;
+  } while (*s++ != '\0');
+  return h;
+}
+
+load_path_dir resolve_load_path_dir(const std::string& dir)
+{
+  struct stat st;
+  std::string lnk;
+  int ret = dwarfs_stat(dir, &st, lnk, true);
+  if (ret == DWARFS_S_LINK_OUTSIDE) {
+    return {load_path_dir::host_dir, 0};
+  }
+  if (ret == DWARFS_IO_CONTINUE && S_ISDIR(st.st_mode)) {
+    return {load_path_dir::memfs_dir, static_cast<tebako_ino_t>(st.st_ino)};
+  }
+  return {load_path_dir::no_dir, 0};
+}
+
+bool is_regular_file(const std::string& path)
+{
+  struct STAT_TYPE st;
+  return tebako_stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+bool probe_memfs_dir(tebako_ino_t ino, const std::string& name)
+{
+  struct stat st;
+  std::string lnk;
+  int ret = dwarfs_inode_relative_stat(ino, name, &st, lnk, true);
+  if (ret == DWARFS_S_LINK_OUTSIDE) {
+    return is_regular_file(lnk);
+  }
+  return ret == DWARFS_IO_CONTINUE && S_ISREG(st.st_mode);
+}
+
+int feature_result(const std::string& path, char* out_path, size_t out_size)
+{
+  if (path.length() >= out_size) {
+    TEBAKO_SET_LAST_ERROR(ERANGE);
+    return -1;
+  }
+  memcpy(out_path, path.c_str(), path.length() + 1);
+  return 0;
+}
+
+}  // namespace
+
+// tebako_resolve_feature
+//  Finds the file that Ruby 'require' would load: for each load path entry in order, for each extension
+//  in order, the first regular file named <entry>/<feature><ext>
+//  Load path directories within memfs are resolved once (per memfs generation) and the feature is probed
+//  relative to the directory inode, so each probe is a short walk rather than a full path lookup.
+//  Absolute features and features starting with '.' are probed as is, without the load path
+//
+// params
+//  exts - NULL-terminated list of extensions, NULL is the same as { "", NULL }
+//  out_path - buffer of out_size bytes for the path found
+//
+// returns
+//  0 - the feature is found [out_path is set]
+//  -1 - error [errno is set, ENOENT if the feature is not found]
+int tebako_resolve_feature(const char* feature,
+                           const char* const* load_path,
+                           size_t n,
+                           const char* const* exts,
+                           char* out_path,
+                           size_t out_size)
+{
+  static const char* const no_exts[] = {"", NULL};
+  if (feature == NULL || out_path == NULL || (load_path == NULL && n != 0)) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+  if (exts == NULL) {
+    exts = no_exts;
+  }
+
+  try {
+    if (is_tebako_path(feature) || stdfs::path(feature).is_absolute() || feature[0] == '.') {
+      for (const char* const* ext = exts; *ext != NULL; ext++) {
+        std::string candidate = std::string(feature) + *ext;
+        if (is_regular_file(candidate)) {
+          return feature_result(candidate, out_path, out_size);
+        }
+      }
+      TEBAKO_SET_LAST_ERROR(ENOENT);
+      return -1;
+    }
+
+    uint64_t memfs_generation = sync_tebako_memfs_table::get_tebako_memfs_table().get_generation();
+    uint64_t mount_generation = sync_tebako_mount_table::get_tebako_mount_table().get_generation();
+
+    // Normalized load path and its fingerprint
+    std::vector<std::string> dirs(n);
+    uint64_t fingerprint = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; i++) {
+      if (load_path[i] != NULL) {
+        tebako_small_path t_path;
+        const char* p_path = to_tebako_path(t_path, load_path[i]);
+        dirs[i] = p_path ? p_path : load_path[i];
+      }
+      fingerprint = fingerprint_update(fingerprint, dirs[i].c_str());
+    }
+    for (const char* const* ext = exts; *ext != NULL; ext++) {
+      fingerprint = fingerprint_update(fingerprint, *ext);
+    }
+    std::string miss_key = std::string(feature) + '\0' +
+                           std::string(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+
+    std::vector<load_path_dir> resolved(n, load_path_dir{load_path_dir::no_dir, 0});
+    bool all_memfs = true;
+    {
+      auto cache = s_feature_cache.wlock();
+      if (cache->memfs_generation != memfs_generation || cache->mount_generation != mount_generation) {
+        cache->dirs.clear();
+        cache->misses.clear();
+        cache->memfs_generation = memfs_generation;
+        cache->mount_generation = mount_generation;
+      }
+      if (cache->misses.count(miss_key) != 0) {
+        TEBAKO_SET_LAST_ERROR(ENOENT);
+        return -1;
+      }
+      for (size_t i = 0; i < n; i++) {
+        auto it = cache->dirs.find(dirs[i]);
+        if (it != cache->dirs.end()) {
+          resolved[i] = it->second;
+        }
+        else if (load_path[i] != NULL) {
+          resolved[i] = is_tebako_path(dirs[i].c_str()) ? resolve_load_path_dir(dirs[i])
+                                                        : load_path_dir{load_path_dir::host_dir, 0};
+          if (cache->dirs.size() < feature_cache_max_entries) {
+            cache->dirs.emplace(dirs[i], resolved[i]);
+          }
+        }
+        all_memfs = all_memfs && resolved[i].kind != load_path_dir::host_dir;
+      }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      if (resolved[i].kind == load_path_dir::no_dir) {
+        continue;
+      }
+      for (const char* const* ext = exts; *ext != NULL; ext++) {
+        std::string name = std::string(feature) + *ext;
+        bool found = (resolved[i].kind == load_path_dir::memfs_dir)
+                         ? probe_memfs_dir(resolved[i].ino, name)
+                         : is_regular_file((stdfs::path(dirs[i]) / name).string());
+        if (found) {
+          return feature_result((stdfs::path(dirs[i]) / name).generic_string(), out_path, out_size);
+        }
+      }
+    }
+
+    if (all_memfs) {
+      auto cache = s_feature_cache.wlock();
+      if (cache->memfs_generation == memfs_generation && cache->mount_generation == mount_generation &&
+          cache->misses.size() < feature_cache_max_entries) {
+        cache->misses.insert(std::move(miss_key));
+      }
+    }
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return -1;
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+}
@@ -0,0 +1,146 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-dirent.h>
+#include <tebako-memfs.h>
+#include <tebako-io.h>
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs-table.h>
+#include <tebako-mount-table.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace tebako {
+
+namespace {
+
+// fork handlers
+// The tables are locked before fork, so that the child does not get them in the middle
+// of an update made by another thread. In the child mounted images are scheduled for
+// reload, since dwarfs worker threads are not copied by fork
+void prepare_fork(void)
+{
+  sync_tebako_memfs_table::get_tebako_memfs_table().lock_for_fork();
+  sync_tebako_mount_table::get_tebako_mount_table().lock_for_fork();
+}
+
+void parent_after_fork(void)
+{
+  sync_tebako_mount_table::get_tebako_mount_table().unlock_after_fork();
+  sync_tebako_memfs_table::get_tebako_memfs_table().unlock_after_fork(false);
+}
+
+void child_after_fork(void)
+{
+  sync_tebako_mount_table::get_tebako_mount_table().unlock_after_fork();
+  sync_tebako_memfs_table::get_tebako_memfs_table().unlock_after_fork(true);
+}
+
+void warmup_noop(const char*, const void*, size_t, int, void*) {}
+
+}  // namespace
+
+void register_fork_handlers(void) noexcept
+{
+#ifndef _WIN32
+  static std::once_flag fork_handlers_flag;
+  try {
+    std::call_once(fork_handlers_flag, []() { pthread_atfork(prepare_fork, parent_after_fork, child_after_fork); });
+  }
+  catch (...) {
+    // std::system_error may be thrown by call_once
+  }
+#endif
+}
+
+}  // namespace tebako
+
+using namespace tebako;
+
+// tebako_prefork_warmup
+//  Reads files and folders (recursively) that are hot in the worker processes
+//  Shall be called by the master process of prefork server before workers are forked,
+//  so that the decompressed data is shared by the workers copy-on-write (or via the
+//  shared cache, if it is enabled) and is not decompressed by each of them
+//
+// returns
+//  the number of files read
+//  -1 - error [errno is set]
+int tebako_prefork_warmup(const char* const* paths, size_t n)
+{
+  if (paths == NULL && n != 0) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+
+  try {
+    std::vector<std::string> files;
+    for (size_t i = 0; i < n; ++i) {
+      if (paths[i] == NULL) {
+        continue;
+      }
+      struct stat st;
+      std::string lnk;
+      tebako_small_path t_path;
+      const char* p_path = to_tebako_path(t_path, paths[i]);
+      if (p_path == NULL || dwarfs_stat(p_path, &st, lnk, true) != DWARFS_IO_CONTINUE) {
+        continue;  // Nothing to warm up
+      }
+      if (!S_ISDIR(st.st_mode)) {
+        files.emplace_back(paths[i]);
+        continue;
+      }
+      std::vector<memfs_tree_entry> entries;
+      if (inode_memfs_call(&memfs::list_tree, st.st_ino, entries) == DWARFS_IO_CONTINUE) {
+        for (const auto& e : entries) {
+          if (S_ISREG(e.st.st_mode)) {
+            files.push_back((stdfs::path(paths[i]) / e.path).string());
+          }
+        }
+      }
+    }
+
+    std::vector<const char*> p_files;
+    p_files.reserve(files.size());
+    for (const auto& f : files) {
+      p_files.push_back(f.c_str());
+    }
+    return tebako_read_many(p_files.data(), p_files.size(), warmup_noop, NULL);
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+}
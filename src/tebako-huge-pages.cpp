@@ -0,0 +1,71 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+
+#include <fstream>
+#include <string>
+
+#include <folly/portability/SysMman.h>
+
+#include <tebako-huge-pages.h>
+
+namespace tebako {
+
+bool huge_page_image::thp_available(void)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  // The file contains something like "always [madvise] never"
+  // THP can be requested with madvise unless the kernel says "[never]"
+  std::ifstream thp("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string mode;
+  return thp && std::getline(thp, mode) && mode.find("[never]") == std::string::npos;
+#else
+  return false;
+#endif
+}
+
+huge_page_image::huge_page_image(const void* data, size_t size) : data_(data), size_(size), area_size_(0)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (size == 0 || !thp_available()) {
+    return;
+  }
+
+  // Only whole huge pages within the image can be backed by huge pages
+  uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t begin = (start + huge_page_size - 1) & ~(static_cast<uintptr_t>(huge_page_size) - 1);
+  uintptr_t end = (start + size) & ~(static_cast<uintptr_t>(huge_page_size) - 1);
+  if (end > begin && ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0) {
+    area_size_ = end - begin;
+  }
+#endif
+}
+
+}  // namespace tebako
@@ -31,118 +31,115 @@
 #include <tebako-pch-pp.h>
 #include <tebako-common.h>
 
-char* tebako_path_assign(tebako_path_t out, const std::string& in)
+#if !defined(WITH_ASAN)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TEBAKO_PATH_SCAN_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define TEBAKO_PATH_SCAN_NEON
+#endif
+#endif
+
+char* tebako_path_assign(tebako_small_path& out, const std::string& in)
 {
-  strncpy(out, in.c_str(), TEBAKO_PATH_LENGTH);
-  out[TEBAKO_PATH_LENGTH] = '\0';
-  return out;
+  size_t len = std::min(in.size(), TEBAKO_PATH_LENGTH);
+  char* p = out.reserve(len);
+  memcpy(p, in.c_str(), len);
+  out.set_length(len);
+  return p;
 }
 
-static char* tebako_path_assign(tebako_path_t out, const stdfs::path& in, bool win_separator = false)
+static char* tebako_path_assign(tebako_small_path& out, const stdfs::path& in, bool win_separator = false)
 {
   return tebako_path_assign(out, win_separator ? in.string() : in.generic_string());
 }
 
 //  Current working direcory (within tebako memfs)
-//  RW lock implemented with folly tooling
-//  github.com/facebook/folly/blob/master/folly/docs/Synchronized
+//  Readers load an immutable snapshot with a single atomic read, without locking, allocation or virtual calls.
+//  Writers (chdir) build a new pre-normalized snapshot and publish it under a mutex.
+//  Snapshots are never freed while the memfs is mounted, so a reader may keep using the one it has loaded;
+//  they are interned by path, so memory grows only with the number of distinct directories visited.
 
-class tebako_path_s {
- private:
-  stdfs::path p;
+struct tebako_cwd_snapshot {
+  std::string generic;  // lexically normal, generic separators, with trailing separator
+  std::string native;   // the same path with native separators (what getcwd returns)
+  size_t root_len;      // length of the root prefix ("/" or "A:/") that '..' cannot climb above
+};
 
- public:
-  tebako_path_s(void) : p("") {}
-  virtual ~tebako_path_s() {}
+static std::atomic<const tebako_cwd_snapshot*> tebako_cwd{nullptr};
 
-  //	Gets current working directory
-  virtual const char* get_cwd(tebako_path_t cwd, bool win_separator = false)
-  {
-    return tebako_path_assign(cwd, p, win_separator);
-  }
+class tebako_cwd_writer {
+ public:
+  virtual ~tebako_cwd_writer() {}
 
   //	Sets current working directory to lexically normal path
   virtual void set_cwd(const char* path)
   {
+    const tebako_cwd_snapshot* snapshot = nullptr;
     if (path) {
-      p.assign(path);
+      stdfs::path p(path);
       p += "/";
       p = p.lexically_normal();
+      std::string generic = p.generic_string();
+      for (const auto& s : snapshots) {
+        if (s->generic == generic) {
+          snapshot = s.get();
+          break;
+        }
+      }
+      if (snapshot == nullptr) {
+        auto s = std::make_unique<tebako_cwd_snapshot>();
+        s->root_len = p.root_path().generic_string().size();
+        s->native = p.string();
+        s->generic = std::move(generic);
+        snapshot = s.get();
+        snapshots.push_back(std::move(s));
+      }
     }
-    else {
-      p.assign("");
-    }
+    tebako_cwd.store(snapshot, std::memory_order_release);
   }
 
-  //	Checks if the current cwd path is withing tebako memfs
-  virtual bool is_in(void) { return !p.empty(); }
-
-  //  Expands a path withing tebako memfs
-  virtual const char* expand_path(tebako_path_t expanded_path, const char* path)
-  {
-    const char* ret = NULL;
-    if (path != NULL) {
-      stdfs::path rpath = (p / path).lexically_normal();
-      ret = tebako_path_assign(expanded_path, rpath);
-    }
-    return ret;
-  }
+ private:
+  std::vector<std::unique_ptr<const tebako_cwd_snapshot>> snapshots;
 };
 
 template <typename LoggerPolicy>
-class tebako_path_s_l : public tebako_path_s {
+class tebako_cwd_writer_l : public tebako_cwd_writer {
  private:
   LOG_PROXY_DECL(LoggerPolicy);
 
  public:
-  tebako_path_s_l(dwarfs::logger& lgr) : tebako_path_s(), LOG_PROXY_INIT(lgr)
+  tebako_cwd_writer_l(dwarfs::logger& lgr) : tebako_cwd_writer(), LOG_PROXY_INIT(lgr)
   {
     LOG_TRACE << __func__ << " [ constructing ] ";
   }
 
-  virtual ~tebako_path_s_l() { LOG_TRACE << __func__ << " [ destroying ] "; }
-
-  virtual const char* get_cwd(tebako_path_t cwd, bool win_separator = false)
-  {
-    tebako_path_s::get_cwd(cwd, win_separator);
-    LOG_TRACE << __func__ << " returning [ " << cwd << " ]";
-    return cwd;
-  }
+  virtual ~tebako_cwd_writer_l() { LOG_TRACE << __func__ << " [ destroying ] "; }
 
   virtual void set_cwd(const char* path)
   {
     LOG_TRACE << __func__ << " setting [ " << (path ? path : "NULL") << " ]";
-    tebako_path_s::set_cwd(path);
-  }
-
-  virtual bool is_in(void)
-  {
-    bool ret = tebako_path_s::is_in();
-    LOG_TRACE << __func__ << " [ " << (ret ? "true" : "false") << " ]";
-    return ret;
-  }
-
-  virtual const char* expand_path(tebako_path_t expanded_path, const char* path)
-  {
-    tebako_path_s::expand_path(expanded_path, path);
-    LOG_TRACE << __func__ << " expanding [ " << (path ? path : NULL) << " --> " << expanded_path << " ]";
-    return expanded_path;
+    tebako_cwd_writer::set_cwd(path);
   }
 };
 
-static folly::Synchronized<tebako_path_s*> tebako_cwd{NULL};
+static folly::Synchronized<tebako_cwd_writer*, std::mutex> tebako_cwd_w{NULL};
 
 void tebako_init_cwd(dwarfs::logger& lgr, bool need_debug_policy)
 {
-  auto locked = tebako_cwd.wlock();
-  // *locked = new tebako_path_s;
-  *locked = (need_debug_policy) ? static_cast<tebako_path_s*>(new tebako_path_s_l<dwarfs::debug_logger_policy>(lgr))
-                                : static_cast<tebako_path_s*>(new tebako_path_s_l<dwarfs::prod_logger_policy>(lgr));
+  auto locked = tebako_cwd_w.lock();
+  tebako_cwd.store(nullptr, std::memory_order_release);
+  delete *locked;
+  *locked = (need_debug_policy)
+                ? static_cast<tebako_cwd_writer*>(new tebako_cwd_writer_l<dwarfs::debug_logger_policy>(lgr))
+                : static_cast<tebako_cwd_writer*>(new tebako_cwd_writer_l<dwarfs::prod_logger_policy>(lgr));
 }
 
 void tebako_drop_cwd(void)
 {
-  auto locked = tebako_cwd.wlock();
+  auto locked = tebako_cwd_w.lock();
+  tebako_cwd.store(nullptr, std::memory_order_release);
   if (*locked) {
     delete *locked;
     *locked = NULL;
@@ -150,10 +147,10 @@ void tebako_drop_cwd(void)
 }
 
 //	Gets current working directory
-const char* tebako_get_cwd(tebako_path_t cwd, bool win_separator)
+const char* tebako_get_cwd(tebako_small_path& cwd, bool win_separator)
 {
-  auto locked = tebako_cwd.rlock();
-  return (*locked) ? (*locked)->get_cwd(cwd, win_separator) : "";
+  const tebako_cwd_snapshot* snapshot = tebako_cwd.load(std::memory_order_acquire);
+  return snapshot ? tebako_path_assign(cwd, win_separator ? snapshot->native : snapshot->generic) : "";
 }
 
 //	Sets current working directory to lexically normal path
@@ -161,7 +158,7 @@ bool tebako_set_cwd(const char* path)
 {
   bool ret = false;
   try {
-    auto locked = tebako_cwd.wlock();
+    auto locked = tebako_cwd_w.lock();
     // *locked == NULL is not an error condition
     if (*locked) {
       (*locked)->set_cwd(path);
@@ -173,6 +170,224 @@ bool tebako_set_cwd(const char* path)
   return ret;
 }
 
+static inline bool is_tebako_separator(char c)
+{
+#ifdef _WIN32
+  return c == '/' || c == '\\';
+#else
+  return c == '/';
+#endif
+}
+
+// tebako_path_join
+//  Appends path components to a lexically normal directory already placed in out[0..len)
+//  (with trailing separator) and normalizes the result in place, following the rules of
+//  std::filesystem::path::lexically_normal: empty and '.' components are dropped, '..'
+//  removes the preceding component but never climbs above out[0..root_len), and a trailing
+//  separator is kept if the path ends with a separator, '.' or '..'
+//
+// params
+//  out - output buffer that can hold cap characters plus terminating '\0'
+//
+// returns
+//  the length of the result
+//  (size_t)-1 if the result does not fit into the buffer
+static size_t tebako_path_join(char* out, size_t cap, size_t len, size_t root_len, const char* path)
+{
+  bool trailing_sep = true;
+  const char* c = path;
+  while (*c != '\0') {
+    const char* b = c;
+    while (*c != '\0' && !is_tebako_separator(*c)) {
+      ++c;
+    }
+    size_t n = c - b;
+    bool has_sep = (*c != '\0');
+    if (has_sep) {
+      ++c;
+    }
+
+    if (n == 0) {
+      continue;
+    }
+    if (n == 1 && b[0] == '.') {
+      trailing_sep = true;
+    }
+    else if (n == 2 && b[0] == '.' && b[1] == '.') {
+      if (len > root_len) {
+        --len;
+        while (len > root_len && out[len - 1] != '/') {
+          --len;
+        }
+      }
+      trailing_sep = true;
+    }
+    else {
+      if (len + n + 1 > cap) {
+        return static_cast<size_t>(-1);
+      }
+      memcpy(out + len, b, n);
+      len += n;
+      out[len++] = '/';
+      trailing_sep = has_sep;
+    }
+  }
+  if (!trailing_sep && len > root_len) {
+    --len;
+  }
+  out[len] = '\0';
+  return len;
+}
+
+#if defined(TEBAKO_PATH_SCAN_SSE2) || defined(TEBAKO_PATH_SCAN_NEON)
+// tebako_path_block_masks
+//  Classifies 16 bytes starting at a 16-byte aligned address
+//  Bit i of sep/dot/zero is set if byte i is '/', '.' or '\0' respectively
+//  Bit i of bsl is set if byte i is a backslash (Windows only, since it needs conversion to
+//  the generic format)
+#if defined(TEBAKO_PATH_SCAN_SSE2)
+static inline void tebako_path_block_masks(const char* block,
+                                           uint32_t& sep,
+                                           uint32_t& dot,
+                                           uint32_t& zero,
+                                           uint32_t& bsl)
+{
+  __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+  sep = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/'))));
+  dot = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.'))));
+  zero = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())));
+#ifdef _WIN32
+  bsl = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+#else
+  bsl = 0;
+#endif
+}
+#else
+static inline uint32_t tebako_path_movemask(uint8x16_t m)
+{
+  static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t b = vandq_u8(m, vld1q_u8(weights));
+  return static_cast<uint32_t>(vaddv_u8(vget_low_u8(b))) | (static_cast<uint32_t>(vaddv_u8(vget_high_u8(b))) << 8);
+}
+
+static inline void tebako_path_block_masks(const char* block,
+                                           uint32_t& sep,
+                                           uint32_t& dot,
+                                           uint32_t& zero,
+                                           uint32_t& bsl)
+{
+  uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(block));
+  sep = tebako_path_movemask(vceqq_u8(v, vdupq_n_u8('/')));
+  dot = tebako_path_movemask(vceqq_u8(v, vdupq_n_u8('.')));
+  zero = tebako_path_movemask(vceqq_u8(v, vdupq_n_u8(0)));
+#ifdef _WIN32
+  bsl = tebako_path_movemask(vceqq_u8(v, vdupq_n_u8('\\')));
+#else
+  bsl = 0;
+#endif
+}
+#endif
+
+// tebako_path_scan
+//  Checks in a single pass, 16 bytes at a time, whether a relative path is already lexically normal
+//  in the generic format, i.e. whether no separator is followed by another separator or by '.',
+//  the path does not start with either, and (on Windows) it has no backslashes.
+//  That is conservative: a component like ".git" sends the path to tebako_path_join as well,
+//  which is correct, only slower.
+//  Blocks are loaded at 16-byte aligned addresses, so the scan never reads across a page boundary
+//  past the terminating '\0'. It is disabled under the address sanitizer that would flag such reads.
+//
+// returns
+//  the length of the path if it is normal
+//  (size_t)-1 otherwise
+static size_t tebako_path_scan(const char* path)
+{
+  uintptr_t addr = reinterpret_cast<uintptr_t>(path);
+  const char* block = reinterpret_cast<const char*>(addr & ~static_cast<uintptr_t>(15));
+  unsigned skip = static_cast<unsigned>(addr & 15);
+  uint32_t carry = 1u << skip;  // the start of the path acts as a separator
+  for (;;) {
+    uint32_t sep, dot, zero, bsl;
+    tebako_path_block_masks(block, sep, dot, zero, bsl);
+    uint32_t valid = 0xFFFFu << skip;
+    sep &= valid;
+    dot &= valid;
+    zero &= valid;
+    uint32_t live = zero ? (zero & (0u - zero)) - 1 : 0xFFFFu;  // bits before the first '\0'
+    if (((((sep << 1) | carry) & (sep | dot)) | bsl) & live & valid) {
+      return static_cast<size_t>(-1);
+    }
+    if (zero) {
+      return static_cast<size_t>(block - path) + __builtin_ctz(zero);
+    }
+    carry = (sep >> 15) & 1u;
+    block += 16;
+    skip = 0;
+  }
+}
+#else
+static size_t tebako_path_scan(const char* path)
+{
+  bool prev_sep = true;
+  const char* c = path;
+  for (; *c != '\0'; ++c) {
+#ifdef _WIN32
+    if (*c == '\\') {
+      return static_cast<size_t>(-1);
+    }
+#endif
+    bool sep = (*c == '/');
+    if (prev_sep && (sep || *c == '.')) {
+      return static_cast<size_t>(-1);
+    }
+    prev_sep = sep;
+  }
+  return static_cast<size_t>(c - path);
+}
+#endif
+
+// tebako_path_append
+//  Appends a relative path to a lexically normal directory already placed in out[0..len)
+//  Paths that are normal already are copied as is, others are normalized by tebako_path_join
+static size_t tebako_path_append(char* out, size_t cap, size_t len, size_t root_len, const char* path)
+{
+  size_t n = tebako_path_scan(path);
+  if (n != static_cast<size_t>(-1) && len + n <= cap) {
+    memcpy(out + len, path, n + 1);
+    return len + n;
+  }
+  return tebako_path_join(out, cap, len, root_len, path);
+}
+
+// tebako_path_expand
+//  Places base (lexically normal, with trailing separator) into out and appends a relative path to it
+//  The inline storage of out is tried first, the heap is used only if the result does not fit there
+//
+// returns
+//  the resulting path
+//  NULL if it is longer than TEBAKO_PATH_LENGTH
+static const char* tebako_path_expand(tebako_small_path& out,
+                                      const char* base,
+                                      size_t base_len,
+                                      size_t root_len,
+                                      const char* path)
+{
+  for (size_t cap = out.capacity();; cap = TEBAKO_PATH_LENGTH) {
+    if (base_len <= cap) {
+      char* p = out.reserve(cap);
+      memcpy(p, base, base_len);
+      size_t len = tebako_path_append(p, cap, base_len, root_len, path);
+      if (len != static_cast<size_t>(-1)) {
+        out.set_length(len);
+        return p;
+      }
+    }
+    if (cap >= TEBAKO_PATH_LENGTH) {
+      return NULL;
+    }
+  }
+}
+
 //  Checks if a path is withing tebako memfs
 #ifdef _WIN32
 bool is_tebako_path(const char* path)
@@ -197,26 +412,52 @@ bool is_tebako_path(const char* path)
 //	Checks if the current cwd path is withing tebako memfs
 extern "C" int is_tebako_cwd(void)
 {
-  auto locked = tebako_cwd.rlock();
-  bool res = (*locked) ? (*locked)->is_in() : false;
-  return res ? -1 : 0;
+  return tebako_cwd.load(std::memory_order_acquire) ? -1 : 0;
+}
+
+//  Checks if a path is relative in the sense that the fast joiner can handle
+//  On Windows paths like "\\dir" or "C:dir" are relative as well, but they are not
+//  relative to cwd and are left to std::filesystem
+static inline bool is_simple_relative_path(const char* path)
+{
+#ifdef _WIN32
+  return !is_tebako_separator(path[0]) && !(path[0] != '\0' && path[1] == ':');
+#else
+  return path[0] != '/';
+#endif
 }
 
 //  Returns tebako path is cwd if within tebako memfs
 //  NULL otherwise
-const char* to_tebako_path(tebako_path_t t_path, const char* path)
+const char* to_tebako_path(tebako_small_path& t_path, const char* path)
 {
   const char* p_path = NULL;
   try {
-    stdfs::path p = path;
-    p = p.lexically_normal();
-    auto locked = tebako_cwd.rlock();
-    if ((*locked) && (*locked)->is_in() && p.is_relative()) {
-      p_path = (*locked)->expand_path(t_path, p.generic_string().c_str());
+    const tebako_cwd_snapshot* snapshot = tebako_cwd.load(std::memory_order_acquire);
+    if (snapshot && is_simple_relative_path(path)) {
+      p_path =
+          tebako_path_expand(t_path, snapshot->generic.c_str(), snapshot->generic.size(), snapshot->root_len, path);
+      if (p_path == NULL) {
+        p_path = tebako_path_assign(t_path, (stdfs::path(snapshot->generic) / path).lexically_normal());
+      }
     }
     else if (is_tebako_path(path)) {
-      p_path = tebako_path_assign(t_path, p);
+#ifdef _WIN32
+      const char root[] = {path[0], path[1], '/'};
+#else
+      const char root[] = {'/'};
+#endif
+      p_path = tebako_path_expand(t_path, root, sizeof(root), sizeof(root), path + sizeof(root));
+      if (p_path == NULL) {
+        p_path = tebako_path_assign(t_path, stdfs::path(path).lexically_normal());
+      }
     }
+#ifdef _WIN32
+    else if (snapshot && stdfs::path(path).is_relative()) {
+      //  Root-relative ("\\dir") and drive-relative ("C:dir") paths
+      p_path = tebako_path_assign(t_path, (stdfs::path(snapshot->generic) / path).lexically_normal());
+    }
+#endif
   }
   catch (...) {
   }
@@ -38,6 +38,7 @@
 #include <tebako-fd.h>
 #include <tebako-mfs.h>
 #include <tebako-memfs-table.h>
+#include <tebako-memfs-overlay.h>
 #include <tebako-mount-table.h>
 
 using namespace dwarfs;
@@ -59,9 +60,19 @@ static int load_memfs(const void* data, const unsigned int size, const char* ima
   LOG_PROXY(debug_logger_policy, memfs::logger());
   LOG_INFO << PRJ_NAME << " mount memfs ";
 
-  int index = sync_tebako_memfs_table::get_tebako_memfs_table().insert_auto(std::make_shared<memfs>(data, size));
-  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(index);
-  if (fs != nullptr && fs->load(image_offset) != 0) {
+  auto fs = std::make_shared<memfs>(data, size);
+  bool lazy = memfs::options().lazy_mount;
+  if (lazy) {
+    // The image is loaded on the first access, see memfs::ensure_loaded
+    fs->defer_load(image_offset);
+  }
+
+  int index = sync_tebako_memfs_table::get_tebako_memfs_table().insert_auto(fs);
+  if (index == 0) {  // No free memfs index
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    index = -1;
+  }
+  else if (!lazy && fs->load(image_offset) != 0) {
     TEBAKO_SET_LAST_ERROR(ENOMEM);
     sync_tebako_memfs_table::get_tebako_memfs_table().erase(index);
     index = -1;
@@ -71,24 +82,80 @@ static int load_memfs(const void* data, const unsigned int size, const char* ima
 
 int mount_memfs(const void* data, const unsigned int size, const char* image_offset, const char* folder)
 {
-  int root_index = sync_tebako_memfs_table::get_tebako_memfs_table().get(0)->get_root_inode();
-  return mount_memfs(data, size, image_offset, root_index, folder);
+  tebako_ino_t root_inode = sync_tebako_memfs_table::get_tebako_memfs_table().get(0)->get_root_inode();
+  return mount_memfs(data, size, image_offset, root_inode, folder);
 }
 
 int mount_memfs(const void* data,
                 const unsigned int size,
                 const char* image_offset,
-                uint32_t parent_inode,
+                tebako_ino_t parent_inode,
                 const char* folder)
 {
   bool res = false;
   int index = load_memfs(data, size, image_offset);
   if (index != -1) {
     res = sync_tebako_mount_table::get_tebako_mount_table().insert(parent_inode, folder, index);
+    if (!res) {
+      TEBAKO_SET_LAST_ERROR(EEXIST);
+      sync_tebako_memfs_table::get_tebako_memfs_table().erase(index);
+    }
   }
   return res ? index : -1;
 }
 
+// mount_memfs
+//  Mounts memfs that has been created (and loaded or deferred) by the caller
+int mount_memfs(std::shared_ptr<memfs> fs, tebako_ino_t parent_inode, const char* folder)
+{
+  auto& memfs_table = sync_tebako_memfs_table::get_tebako_memfs_table();
+  int index = memfs_table.insert_auto(fs);
+  if (index == 0) {  // No free memfs index
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+  if (!sync_tebako_mount_table::get_tebako_mount_table().insert(parent_inode, folder, index)) {
+    // Something is mounted at this point already
+    TEBAKO_SET_LAST_ERROR(EEXIST);
+    memfs_table.erase(index);
+    return -1;
+  }
+  return index;
+}
+
+// mount_memfs_overlay
+//  Mounts the stack of memfs images (layers[0] is the bottom one) as a single overlay
+//  Returns memfs index of the top layer or -1 [errno is set]
+int mount_memfs_overlay(const std::vector<std::shared_ptr<memfs>>& layers, tebako_ino_t parent_inode, const char* folder)
+{
+  auto& memfs_table = sync_tebako_memfs_table::get_tebako_memfs_table();
+  std::vector<uint32_t> indices;
+  bool res = !layers.empty();
+  for (auto layer = layers.begin(); layer != layers.end() && res; ++layer) {
+    uint32_t index = memfs_table.insert_auto(*layer);
+    if (index == 0) {  // No free memfs index
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+      res = false;
+    }
+    else {
+      indices.push_back(index);
+    }
+  }
+
+  if (res) {
+    auto overlay = std::make_shared<memfs_overlay>(indices);
+    res = overlay->build_index() == DWARFS_IO_CONTINUE &&
+          sync_tebako_mount_table::get_tebako_mount_table().insert(parent_inode, folder, overlay);
+  }
+
+  if (!res) {
+    for (auto index : indices) {
+      memfs_table.erase(index);
+    }
+  }
+  return res ? static_cast<int>(indices.back()) : -1;
+}
+
 int mount_root_memfs(const void* data,
                      const unsigned int size,
                      const char* debuglevel,
@@ -114,6 +181,10 @@ int mount_root_memfs(const void* data,
       memfs::set_decompress_ratio(decompress_ratio);
       memfs::set_lock_mode(mlock);
       memfs::set_workers(workers);
+      const char* huge_pages = ::getenv("TEBAKO_HUGE_PAGES");
+      if (huge_pages != nullptr) {
+        memfs::set_huge_pages(huge_pages);
+      }
 
       auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
       if (fs != nullptr) {
@@ -126,6 +197,8 @@ int mount_root_memfs(const void* data,
       if (fs->load(image_offset) == 0) {
         ret = 0;
         tebako_init_cwd(memfs::logger(), memfs::options().debuglevel >= logger::DEBUG);
+        register_fork_handlers();
+        tebako_dl_prefetch_from_env();
       }
       else {
         sync_tebako_memfs_table::get_tebako_memfs_table().erase(0);
@@ -165,12 +238,17 @@ int dwarfs_readlink(const std::string& path, std::string& link, std::string& lnk
 {
   return root_memfs_call(&tebako::memfs::readlink, path, link, lnk);
 }
+
+int dwarfs_realpath(const std::string& path, std::string& canonical, std::string& lnk) noexcept
+{
+  return root_memfs_call(&tebako::memfs::realpath, path, canonical, lnk);
+}
 int dwarfs_stat(const std::string& path, struct stat* buf, std::string& lnk, bool follow) noexcept
 {
   return root_memfs_call(&tebako::memfs::stat, path, buf, lnk, follow);
 }
 
-int dwarfs_inode_access(uint32_t inode, int amode, uid_t uid, gid_t gid) noexcept
+int dwarfs_inode_access(tebako_ino_t inode, int amode, uid_t uid, gid_t gid) noexcept
 {
   return inode_memfs_call(&tebako::memfs::inode_access, inode, amode, uid, gid);
 }
@@ -180,7 +258,7 @@ int dwarfs_relative_stat(const std::string& path, struct stat* st, std::string&
   return root_memfs_call(&tebako::memfs::relative_stat, path, st, lnk, follow);
 }
 
-int dwarfs_inode_relative_stat(uint32_t inode,
+int dwarfs_inode_relative_stat(tebako_ino_t inode,
                                const std::string& path,
                                struct stat* buf,
                                std::string& lnk,
@@ -188,11 +266,11 @@ int dwarfs_inode_relative_stat(uint32_t inode,
 {
   return inode_memfs_call(&tebako::memfs::inode_relative_stat, inode, path, buf, lnk, follow);
 }
-ssize_t dwarfs_inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept
+ssize_t dwarfs_inode_read(tebako_ino_t inode, void* buf, size_t size, off_t offset) noexcept
 {
   return inode_memfs_call(&tebako::memfs::inode_read, inode, buf, size, offset);
 }
-int dwarfs_inode_readdir(uint32_t inode,
+int dwarfs_inode_readdir(tebako_ino_t inode,
                          tebako::tebako_dirent* cache,
                          off_t cache_start,
                          size_t buffer_size,
@@ -227,7 +305,7 @@ int mount_memfs_at_root(const void* data, const unsigned int size, const char* i
 int mount_memfs(const void* data,
                 const unsigned int size,
                 const char* image_offset,
-                unsigned int parent_inode,
+                uint64_t parent_inode,
                 const char* folder)
 {
   return tebako::mount_memfs(data, size, image_offset, parent_inode, folder);
@@ -0,0 +1,231 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-dirent.h>
+#include <tebako-memfs.h>
+#include <tebako-io.h>
+#include <tebako-io-inner.h>
+#include <tebako-memfs-table.h>
+#include <tebako-memfs-overlay.h>
+
+namespace tebako {
+
+// memfs_overlay::merge
+//  Lists the union of directories (topmost first) applying whiteouts
+//  An entry of a lower layer is merged into the entry of the same name only if both are
+//  directories; a non-directory shadows everything below it
+int memfs_overlay::merge(const std::vector<tebako_ino_t>& dirs, std::vector<merged_entry>& entries) noexcept
+{
+  int ret = DWARFS_IO_CONTINUE;
+  try {
+    std::unordered_map<std::string, size_t> positions;  // name --> position in entries, or SIZE_MAX if sealed
+    for (auto dir : dirs) {
+      auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(sync_tebako_memfs_table::getFsIndex(dir));
+      if (fs == nullptr) {
+        TEBAKO_SET_LAST_ERROR(ENOENT);
+        return DWARFS_IO_ERROR;
+      }
+
+      bool opaque = false;
+      std::vector<std::string> whiteouts;
+      ret = fs->dir_entries(dir, [&](const std::string& name, const struct stat& st) {
+        if (name == opaque_marker) {
+          opaque = true;
+          return;
+        }
+        if (name.compare(0, strlen(whiteout_prefix), whiteout_prefix) == 0) {
+          whiteouts.push_back(name.substr(strlen(whiteout_prefix)));
+          return;
+        }
+        auto p = positions.find(name);
+        if (p == positions.end()) {
+          positions.emplace(name, entries.size());
+          entries.push_back(merged_entry{name, st, {}});
+          if (S_ISDIR(st.st_mode)) {
+            entries.back().dirs.push_back(st.st_ino);
+          }
+        }
+        else if (p->second != SIZE_MAX) {
+          auto& e = entries[p->second];
+          if (S_ISDIR(st.st_mode) && !e.dirs.empty()) {
+            e.dirs.push_back(st.st_ino);
+          }
+          else {
+            p->second = SIZE_MAX;
+          }
+        }
+      });
+      if (ret != DWARFS_IO_CONTINUE || opaque) {
+        break;
+      }
+      // Whiteouts hide the entries of the lower layers only
+      for (auto& name : whiteouts) {
+        positions[name] = SIZE_MAX;
+      }
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = DWARFS_IO_ERROR;
+  }
+  return ret;
+}
+
+// memfs_overlay::build_index
+//  Merges the directories that exist in several layers starting from the root
+//  Subtrees that come from a single layer are not traversed
+//
+// returns
+//  DWARFS_IO_CONTINUE - success
+//  DWARFS_IO_ERROR - error [errno is set]
+int memfs_overlay::build_index(void) noexcept
+{
+  int ret = DWARFS_IO_CONTINUE;
+  try {
+    index.clear();
+    merged_dirs.clear();
+
+    std::vector<tebako_ino_t> roots;
+    for (auto layer = layers.rbegin(); layer != layers.rend(); ++layer) {
+      auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(*layer);
+      if (fs == nullptr) {
+        TEBAKO_SET_LAST_ERROR(ENOENT);
+        return DWARFS_IO_ERROR;
+      }
+      if (fs->ensure_loaded() != DWARFS_IO_CONTINUE) {
+        return DWARFS_IO_ERROR;
+      }
+      roots.push_back(fs->get_root_inode());
+    }
+    index.emplace(std::string(), layers.back());
+
+    struct pending_dir {
+      std::string path;
+      uint32_t layer;
+      std::vector<tebako_ino_t> dirs;
+    };
+    std::vector<pending_dir> pending;
+    pending.push_back(pending_dir{std::string(), layers.back(), std::move(roots)});
+
+    while (!pending.empty() && ret == DWARFS_IO_CONTINUE) {
+      pending_dir d = std::move(pending.back());
+      pending.pop_back();
+
+      std::vector<merged_entry> entries;
+      ret = merge(d.dirs, entries);
+      for (auto& e : entries) {
+        std::string path = d.path.empty() ? e.name : d.path + '/' + e.name;
+        uint32_t layer = sync_tebako_memfs_table::getFsIndex(e.st.st_ino);
+        if (layer != d.layer) {
+          index.emplace(path, layer);
+        }
+        if (e.dirs.size() > 1) {
+          pending.push_back(pending_dir{std::move(path), layer, std::move(e.dirs)});
+        }
+      }
+      if (d.dirs.size() > 1) {
+        tebako_ino_t top = d.dirs.front();
+        merged_dirs.emplace(top, std::move(d.dirs));
+      }
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = DWARFS_IO_ERROR;
+  }
+  if (ret != DWARFS_IO_CONTINUE) {
+    index.clear();
+    merged_dirs.clear();
+  }
+  return ret;
+}
+
+// memfs_overlay::resolve
+//  Returns memfs index of the layer that shall resolve the path (relative to overlay root)
+//  The layer is the one of the longest indexed prefix of the path. A path that does not exist
+//  or is hidden by a whiteout is resolved to a layer where it does not exist
+uint32_t memfs_overlay::resolve(const stdfs::path& path) const
+{
+  stdfs::path p = path;
+  while (!p.empty()) {
+    auto entry = index.find(p.generic_string());
+    if (entry != index.end()) {
+      return entry->second;
+    }
+    auto parent = p.parent_path();
+    if (parent == p) {
+      break;
+    }
+    p = std::move(parent);
+  }
+  return layers.back();
+}
+
+// memfs_overlay::readdir
+//  Fills directory cache with the merged content of directory that exists in several layers
+//  "." and ".." are reported with the stat of the topmost directory
+int memfs_overlay::readdir(tebako_ino_t inode,
+                           tebako_dirent* cache,
+                           off_t cache_start,
+                           size_t buffer_size,
+                           size_t& cache_size,
+                           size_t& dir_size) const noexcept
+{
+  cache_size = 0;
+  auto dirs = merged_dirs.find(inode);
+  if (dirs == merged_dirs.end()) {
+    TEBAKO_SET_LAST_ERROR(ENOTDIR);
+    return DWARFS_IO_ERROR;
+  }
+
+  std::vector<merged_entry> entries;
+  struct stat dir_st;
+  std::string lnk;
+  if (merge(dirs->second, entries) != DWARFS_IO_CONTINUE ||
+      dwarfs_inode_relative_stat(inode, "", &dir_st, lnk, false) != DWARFS_IO_CONTINUE) {
+    return DWARFS_IO_ERROR;
+  }
+
+  const size_t n_dots = 2;
+  dir_size = entries.size() + n_dots;
+  for (size_t pos = cache_start; pos < dir_size && cache_size < buffer_size; ++pos, ++cache_size) {
+    if (pos < n_dots) {
+      fill_dirent(cache[cache_size], pos == 0 ? "." : "..", dir_st, pos);
+    }
+    else {
+      fill_dirent(cache[cache_size], entries[pos - n_dots].name, entries[pos - n_dots].st, pos);
+    }
+  }
+  return 0;
+}
+
+}  // namespace tebako
@@ -42,45 +42,152 @@ using namespace dwarfs;
 
 namespace tebako {
 
+namespace {
+
+// Per-thread reader state
+// epoch is odd while the thread is within memfs_table_reader
+struct alignas(64) table_reader_record {
+  std::atomic<uint64_t> epoch{0};
+  uint32_t depth{0};
+};
+
+folly::Synchronized<std::vector<table_reader_record*>, std::mutex>& table_readers(void)
+{
+  static folly::Synchronized<std::vector<table_reader_record*>, std::mutex> readers;
+  return readers;
+}
+
+struct table_reader_registration {
+  table_reader_record record;
+
+  table_reader_registration() { table_readers().lock()->push_back(&record); }
+  ~table_reader_registration()
+  {
+    auto readers = table_readers().lock();
+    readers->erase(std::remove(readers->begin(), readers->end(), &record), readers->end());
+  }
+};
+
+thread_local table_reader_registration t_reader;
+
+// Held across fork, so that the child does not inherit the registry locked by another thread
+std::optional<folly::Synchronized<std::vector<table_reader_record*>, std::mutex>::LockedPtr> fork_readers_lock;
+
+// Waits until every thread that was within memfs_table_reader when the snapshot was swapped has left it
+void wait_for_readers(void)
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto* self = &t_reader.record;  // registers the calling thread before the registry is locked
+  auto readers = table_readers().lock();
+  for (auto* r : *readers) {
+    if (r == self) {
+      continue;
+    }
+    uint64_t epoch = r->epoch.load(std::memory_order_acquire);
+    if (epoch & 1) {
+      while (r->epoch.load(std::memory_order_acquire) == epoch) {
+        std::this_thread::yield();
+      }
+    }
+  }
+}
+
+}  // namespace
+
+memfs_table_reader::memfs_table_reader()
+{
+  auto& r = t_reader.record;
+  if (r.depth++ == 0) {
+    r.epoch.store(r.epoch.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // Pairs with the fence in wait_for_readers: either the writer sees this reader or the reader sees the new snapshot
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+memfs_table_reader::~memfs_table_reader()
+{
+  auto& r = t_reader.record;
+  if (--r.depth == 0) {
+    r.epoch.store(r.epoch.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+}
+
+bool memfs_table_reader::active(void)
+{
+  return t_reader.record.depth != 0;
+}
+
 sync_tebako_memfs_table& sync_tebako_memfs_table::get_tebako_memfs_table(void)
 {
   static sync_tebako_memfs_table memfs_table{};
   return memfs_table;
 }
 
+sync_tebako_memfs_table::~sync_tebako_memfs_table()
+{
+  for (auto* r : retired) {
+    delete r;
+  }
+  delete snapshot.load(std::memory_order_relaxed);
+}
+
+// sync_tebako_memfs_table::publish
+//  Replaces the snapshot with the copy of the table; called with the map locked for writing
+//  The previous snapshot is released once no reader can see it. If the calling thread is a reader itself,
+//  it cannot wait for itself, so the snapshot is kept until the next publish
+void sync_tebako_memfs_table::publish(const tebako_memfs_table& table)
+{
+  auto next = new memfs_table_snapshot;
+  if (!table.empty()) {
+    next->slots.resize(table.rbegin()->first + 1);
+    for (const auto& pair : table) {
+      next->slots[pair.first] = pair.second;
+    }
+  }
+  retired.push_back(snapshot.exchange(next, std::memory_order_acq_rel));
+  generation.fetch_add(1, std::memory_order_acq_rel);
+  if (!memfs_table_reader::active()) {
+    wait_for_readers();
+    for (auto* r : retired) {
+      delete r;
+    }
+    retired.clear();
+  }
+}
+
 bool sync_tebako_memfs_table::check(uint32_t index)
 {
-  auto p_memfs_table = s_tebako_memfs_table.rlock();
-  auto p_memfs = p_memfs_table->find(index);
-  return (p_memfs != p_memfs_table->end());
+  memfs_table_reader reader;
+  return peek(index) != nullptr;
 }
 
 void sync_tebako_memfs_table::clear(void)
 {
   auto p_memfs_table = s_tebako_memfs_table.wlock();
   p_memfs_table->clear();
+  publish(*p_memfs_table);
 }
 
 void sync_tebako_memfs_table::erase(uint32_t index)
 {
   auto p_memfs_table = s_tebako_memfs_table.wlock();
   auto p_memfs = p_memfs_table->extract(index);
+  publish(*p_memfs_table);
 }
 
 std::shared_ptr<memfs> sync_tebako_memfs_table::get(uint32_t index)
 {
-  auto p_memfs_table = s_tebako_memfs_table.rlock();
-  auto p_memfs = p_memfs_table->find(index);
-  if (p_memfs != p_memfs_table->end()) {
-    return p_memfs->second;
-  }
-  return nullptr;
+  memfs_table_reader reader;
+  const memfs_table_snapshot* snap = snapshot.load(std::memory_order_acquire);
+  return index < snap->slots.size() ? snap->slots[index] : nullptr;
 }
 
 bool sync_tebako_memfs_table::insert(uint32_t index, std::shared_ptr<memfs> fs)
 {
   auto p_memfs_table = s_tebako_memfs_table.wlock();
-  return p_memfs_table->emplace(index, fs).second;
+  bool ret = p_memfs_table->emplace(index, fs).second;
+  publish(*p_memfs_table);
+  return ret;
 }
 
 uint32_t sync_tebako_memfs_table::insert_auto(std::shared_ptr<memfs> fs)
@@ -97,12 +204,38 @@ uint32_t sync_tebako_memfs_table::insert_auto(std::shared_ptr<memfs> fs)
     }
   }
 
-  if (index > 7) {  // Only three bits to store memfs index
+  if (index > fsMask) {  // No more bits to store memfs index
     return 0;
   }
   fs->set_root_inode(sync_tebako_memfs_table::fsInoFromFsAndIno(index, 0));
   p_memfs_table->emplace(index, fs);
+  publish(*p_memfs_table);
   return index;
 }
 
+void sync_tebako_memfs_table::lock_for_fork(void)
+{
+  fork_lock.emplace(s_tebako_memfs_table.wlock());
+  static_cast<void>(&t_reader);  // registers the forking thread before the registry is locked
+  fork_readers_lock.emplace(table_readers().lock());
+}
+
+void sync_tebako_memfs_table::unlock_after_fork(bool child)
+{
+  if (fork_lock) {
+    if (child) {
+      for (auto& pair : **fork_lock) {
+        pair.second->reload_after_fork();
+      }
+      // Other threads do not exist in the child, they shall not be waited for
+      if (fork_readers_lock) {
+        (*fork_readers_lock)->clear();
+        (*fork_readers_lock)->push_back(&t_reader.record);
+      }
+    }
+    fork_readers_lock.reset();
+    fork_lock.reset();
+  }
+}
+
 }  // namespace tebako
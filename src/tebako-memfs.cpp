@@ -36,6 +36,7 @@
 #include <tebako-io-inner.h>
 #include <tebako-mfs.h>
 #include <tebako-memfs-table.h>
+#include <tebako-memfs-overlay.h>
 #include <tebako-mount-table.h>
 
 using namespace dwarfs;
@@ -67,19 +68,54 @@ memfs_options& memfs::options()
   return opts;
 }
 
-memfs::memfs(const void* dt, const unsigned int sz, uint32_t df_root_inode)
+memfs::memfs(const void* dt, const unsigned int sz, tebako_ino_t df_root_inode)
     : data{dt}, size{sz}, dwarfs_root_inode(df_root_inode)
 {
   fsopts << options();
 }
 
+memfs::memfs(std::vector<char>&& image, tebako_ino_t df_root_inode)
+    : owned_image(std::move(image)),
+      data{owned_image.data()},
+      size{static_cast<unsigned int>(owned_image.size())},
+      dwarfs_root_inode(df_root_inode)
+{
+  fsopts << options();
+}
+
 int memfs::load(const char* image_offset)
 {
   LOG_PROXY(debug_logger_policy, logger());
 
   try {
     set_image_offset_str(image_offset);
-    fs = filesystem_v2(logger(), std::make_shared<tebako::mfs>(data, size), fsopts, dwarfs_root_inode, nullptr);
+    if (options().huge_pages) {
+      if (!hp_image) {
+        hp_image = std::make_unique<huge_page_image>(data, size);
+      }
+      LOG_DEBUG << "Huge pages " << (hp_image->is_huge() ? "are requested" : "are not available") << " for memfs image ["
+                << hp_image->huge_size() << " of " << hp_image->size() << " bytes]";
+    }
+    // dwarfs inode numbers are not shifted, memfs index is added by to_tebako_inode
+    fs = filesystem_v2(logger(), std::make_shared<tebako::mfs>(data, size), fsopts, 0, nullptr);
+    dwarfs::vfs_stat vfs_st;
+    if (fs.statvfs(&vfs_st) == 0) {
+      if (!sync_tebako_memfs_table::fitsInodeCount(vfs_st.files)) {
+        LOG_ERROR << "The image has " << vfs_st.files << " inodes, at most "
+                  << static_cast<uint64_t>(sync_tebako_memfs_table::inoMask) + 1 << " are supported on this platform";
+        TEBAKO_SET_LAST_ERROR(EOVERFLOW);
+        return -1;
+      }
+      stat_cache.reserve(vfs_st.files);
+    }
+    if (!options().disk_cache_dir.empty() && !dcache) {
+      dcache = std::make_unique<disk_cache>(options().disk_cache_dir, data, size, options().disk_cache_max_entry);
+      LOG_DEBUG << "Persistent cache of decompressed files is at " << dcache->directory();
+    }
+    if (options().shared_cache_size != 0 && !scache) {
+      scache = std::make_unique<shared_cache>(options().shared_cache_size, options().shared_cache_max_entry);
+      LOG_DEBUG << "Shared cache of decompressed files is " << (scache->is_available() ? "created" : "not available");
+    }
     LOG_TIMED_INFO << "Filesystem initialized";
   }
 
@@ -99,6 +135,65 @@ int memfs::load(const char* image_offset)
   return 0;
 }
 
+// memfs::defer_load
+//  Registers memfs image without loading it
+//  The image is loaded by ensure_loaded on the first access
+void memfs::defer_load(const char* image_offset)
+{
+  deferred_image_offset = image_offset != nullptr ? image_offset : "auto";
+  state.store(load_state::deferred, std::memory_order_release);
+}
+
+// memfs::ensure_loaded
+//  Loads deferred memfs image (once)
+//
+// returns
+//  DWARFS_IO_CONTINUE - success [memfs is loaded]
+//  DWARFS_IO_ERROR - error [errno is set]
+int memfs::ensure_loaded(void) noexcept
+{
+  if (!is_loaded()) {
+    try {
+      std::call_once(*deferred_load_flag, [this]() {
+        LOG_PROXY(debug_logger_policy, logger());
+        LOG_DEBUG << __func__ << " [ loading deferred memfs @inode:" << dwarfs_root_inode << " ]";
+        const char* image_offset = deferred_image_offset.empty() ? nullptr : deferred_image_offset.c_str();
+        state.store(load(image_offset) == 0 ? load_state::loaded : load_state::failed,
+                    std::memory_order_release);
+      });
+    }
+    catch (...) {
+      // std::system_error may be thrown by call_once
+    }
+    if (!is_loaded()) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+      return DWARFS_IO_ERROR;
+    }
+  }
+  return DWARFS_IO_CONTINUE;
+}
+
+// memfs::reload_after_fork
+//  Called in the child process after fork
+//  dwarfs worker threads do not exist in the child and the filesystem object may be
+//  captured mid-operation, so it is abandoned (its destructor would wait for the threads)
+//  and the image is loaded again on the first access. The image memory and
+//  decompressed file caches are kept.
+void memfs::reload_after_fork(void) noexcept
+{
+  if (state.load(std::memory_order_acquire) == load_state::loaded) {
+    try {
+      new dwarfs::filesystem_v2(std::move(fs));  // Leaked intentionally
+      deferred_load_flag = std::make_unique<std::once_flag>();
+      deferred_image_offset.clear();  // Keep the offset that has been set by load
+      state.store(load_state::deferred, std::memory_order_release);
+    }
+    catch (...) {
+      state.store(load_state::failed, std::memory_order_release);
+    }
+  }
+}
+
 void memfs::set_cachesize(const char* cachesize)
 {
   options().cachesize = (cachesize != nullptr) ? parse_size_with_unit(cachesize) : (static_cast<size_t>(512) << 20);
@@ -109,6 +204,8 @@ void memfs::set_debuglevel(const char* debuglevel)
   options().debuglevel = (debuglevel != nullptr) ? logger::parse_level(debuglevel) : logger::INFO;
   logger().set_threshold(options().debuglevel);
   logger().set_with_context(options().debuglevel >= logger::DEBUG);
+  find_inode_p = (options().debuglevel >= logger::DEBUG) ? &memfs::find_inode_impl<debug_logger_policy>
+                                                         : &memfs::find_inode_impl<prod_logger_policy>;
 }
 
 void memfs::set_decompress_ratio(const char* decompress_ratio)
@@ -119,6 +216,21 @@ void memfs::set_decompress_ratio(const char* decompress_ratio)
   }
 }
 
+void memfs::set_disk_cache(const char* directory)
+{
+  options().disk_cache_dir = (directory != nullptr) ? directory : "";
+}
+
+void memfs::set_huge_pages(const char* huge_pages)
+{
+  options().huge_pages = (huge_pages != nullptr) ? folly::to<bool>(huge_pages) : 0;
+}
+
+void memfs::set_lazy_mount(const char* lazy_mount)
+{
+  options().lazy_mount = (lazy_mount != nullptr) ? folly::to<bool>(lazy_mount) : 0;
+}
+
 void memfs::set_image_offset_str(const char* image_offset_str)
 {
   if (image_offset_str) {
@@ -138,6 +250,11 @@ void memfs::set_lock_mode(const char* mlock)
   options().lock_mode = (mlock != nullptr) ? parse_mlock_mode(mlock) : mlock_mode::NONE;
 }
 
+void memfs::set_shared_cache(const char* size)
+{
+  options().shared_cache_size = (size != nullptr) ? parse_size_with_unit(size) : 0;
+}
+
 void memfs::set_workers(const char* workers)
 {
   options().workers = (workers != nullptr) ? folly::to<size_t>(workers) : 2;
@@ -145,10 +262,11 @@ void memfs::set_workers(const char* workers)
 
 // *** Now this is the core function ***
 //
-// memfs::find_inode
+// memfs::find_inode_impl
 //   Finds inode
 //   Converts mount points to links
 //   Follows relative links
+//   LoggerPolicy is selected once by set_debuglevel (memfs::find_inode dispatches through find_inode_p)
 //
 // params
 //  start_from - inode number to start from
@@ -162,26 +280,28 @@ void memfs::set_workers(const char* workers)
 //  DWARFS_IO_ERROR - error [errno is set]
 //  DWARFS_LINK - symlink or mount point  [lnk is set]
 
-int memfs::find_inode(uint32_t start_from,
-                      const stdfs::path& path,
-                      bool follow_last,
-                      std::string& lnk,
-                      struct stat* st) noexcept
+template <typename LoggerPolicy>
+int memfs::find_inode_impl(tebako_ino_t start_from,
+                           const stdfs::path& path,
+                           bool follow_last,
+                           std::string& lnk,
+                           struct stat* st) noexcept
 {
   int ret = DWARFS_IO_CONTINUE;
-  dwarfs::file_stat dwarfs_st;
+  struct stat i_st {};
   stdfs::path p_path{path};  // a copy of the path, mangled if symlink is found
 
   try {
-    LOG_PROXY(debug_logger_policy, logger());
+    LOG_PROXY(LoggerPolicy, logger());
     LOG_DEBUG << __func__ << " [ @inode:" << start_from << " path:" << path << " ]";
 
-    auto pi = fs.find(start_from);
+    auto pi = fs.find(to_dwarfs_inode(start_from));
     auto p_iterator = p_path.begin();
-    auto m_table = sync_tebako_mount_table::get_tebako_mount_table();
+    auto& m_table = sync_tebako_mount_table::get_tebako_mount_table();
 
     if (pi) {
-      ret = process_inode(*pi, &dwarfs_st, follow_last, lnk, p_iterator, p_path);
+      ret = process_inode(*pi, &i_st, follow_last, lnk, p_iterator, p_path);
+      bool pi_is_dir = S_ISDIR(i_st.st_mode);
       while (p_iterator != p_path.end() && !p_iterator->empty() && ret == DWARFS_IO_CONTINUE) {
         auto inode = pi->inode_num() + get_root_inode();
         auto mount_point = m_table.get(inode, p_iterator->string());
@@ -197,16 +317,22 @@ int memfs::find_inode(uint32_t start_from,
               continue;
             }
           }
-          else if (std::holds_alternative<uint32_t>(*mount_point)) {
-            uint32_t index = std::get<uint32_t>(*mount_point);
+          else if (std::holds_alternative<uint32_t>(*mount_point) ||
+                   std::holds_alternative<std::shared_ptr<memfs_overlay>>(*mount_point)) {
+            stdfs::path next_path = stdfs::path("");
+            while (++p_iterator != p_path.end()) {
+              next_path /= p_iterator->string();
+            }
+            uint32_t index = std::holds_alternative<uint32_t>(*mount_point)
+                                 ? std::get<uint32_t>(*mount_point)
+                                 : std::get<std::shared_ptr<memfs_overlay>>(*mount_point)->resolve(next_path);
             LOG_DEBUG << __func__ << " [ mount point --> memfs:\"" << index << "\" ]";
             auto next_memfs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(index);
             if (next_memfs != nullptr) {
-              auto next_inode = next_memfs->get_root_inode();
-              stdfs::path next_path = stdfs::path("");
-              while (++p_iterator != p_path.end()) {
-                next_path /= p_iterator->string();
+              if (next_memfs->ensure_loaded() != DWARFS_IO_CONTINUE) {
+                return DWARFS_IO_ERROR;
               }
+              auto next_inode = next_memfs->get_root_inode();
               return next_memfs->find_inode(next_inode, next_path, follow_last, lnk, st);
             }
             else {
@@ -221,17 +347,25 @@ int memfs::find_inode(uint32_t start_from,
             ret = DWARFS_IO_ERROR;
           }
         }
+        // A path component under a file, resolved without asking dwarfs to look into a non-directory
+        else if (!pi_is_dir) {
+          TEBAKO_SET_LAST_ERROR(ENOTDIR);
+          ret = DWARFS_IO_ERROR;
+        }
         else {
           auto pi_prev = pi;
-          pi = fs.find(inode, p_iterator->string().c_str());
+          pi = fs.find(pi->inode_num(), p_iterator->string().c_str());
 
           if (pi) {
-            ret = process_inode(*pi, &dwarfs_st, follow_last, lnk, p_iterator, p_path);
+            ret = process_inode(*pi, &i_st, follow_last, lnk, p_iterator, p_path);
+            pi_is_dir = S_ISDIR(i_st.st_mode);
             if (ret == DWARFS_S_LINK_RELATIVE || ret == DWARFS_S_LINK_ABSOLUTE) {
               LOG_DEBUG << __func__ << " [ reparse point --> \"" << lnk << "\" ]";
             }
             if (ret == DWARFS_S_LINK_RELATIVE) {
+              // The link is resolved against its parent directory
               pi = pi_prev;
+              pi_is_dir = true;
               ret = DWARFS_IO_CONTINUE;
               continue;
             }
@@ -254,11 +388,8 @@ int memfs::find_inode(uint32_t start_from,
     }
     // Copy the stat structure only if there is no error
     if (ret != DWARFS_IO_ERROR) {
-#if defined(_WIN32)
-      copy_file_stat<false>(st, dwarfs_st);
-#else
-      copy_file_stat<true>(st, dwarfs_st);
-#endif
+      *st = i_st;
+      st->st_ino = to_tebako_inode(st->st_ino);
     }
   }
   catch (dwarfs::system_error const& e) {
@@ -272,8 +403,11 @@ int memfs::find_inode(uint32_t start_from,
   return ret;
 }
 
+memfs::find_inode_fn memfs::find_inode_p = &memfs::find_inode_impl<prod_logger_policy>;
+
 // memfs::find_inode_abs
 // Finds inode and follows absolute link if it is within memfs
+// Absolute links are followed by restarting the walk from the root memfs, at most TEBAKO_MAX_LINK_HOPS times
 //
 // params
 //  start_from - inode number to start from
@@ -284,10 +418,10 @@ int memfs::find_inode(uint32_t start_from,
 //
 // returns
 //  DWARFS_IO_CONTINUE - success [st is filled]
-//  DWARFS_IO_ERROR - error [errno is set]
-//  DWARFS_LINK - symlink or mount point  [lnk is set]
+//  DWARFS_IO_ERROR - error [errno is set, ELOOP if there are too many links]
+//  DWARFS_S_LINK_OUTSIDE - symlink or mount point outside of memfs [lnk is set]
 
-int memfs::find_inode_abs(uint32_t start_from,
+int memfs::find_inode_abs(tebako_ino_t start_from,
                           const stdfs::path& path,
                           bool follow,
                           std::string& lnk,
@@ -296,25 +430,30 @@ int memfs::find_inode_abs(uint32_t start_from,
   int ret = DWARFS_IO_ERROR;
   try {
     ret = find_inode(start_from, path, follow, lnk, st);
-    // Follow absolute links if necessary
-    // (indirect recursion)
-    if (ret == DWARFS_S_LINK_ABSOLUTE) {
-      if (is_tebako_path(lnk.c_str())) {
-        if (follow) {
-#ifdef RB_W32
-          struct STAT_TYPE _st;
-          ret = tebako_stat(lnk.c_str(), &_st);
-          st << _st;
-#else
-          ret = tebako_stat(lnk.c_str(), st);
-#endif
-        }
-        else {
-          ret = DWARFS_IO_CONTINUE;
-        }
+    for (int hops = 0; ret == DWARFS_S_LINK_ABSOLUTE; hops++) {
+      if (!is_tebako_path(lnk.c_str())) {
+        ret = DWARFS_S_LINK_OUTSIDE;
+      }
+      else if (!follow) {
+        ret = DWARFS_IO_CONTINUE;
+      }
+      else if (hops >= TEBAKO_MAX_LINK_HOPS) {
+        TEBAKO_SET_LAST_ERROR(ELOOP);
+        ret = DWARFS_IO_ERROR;
       }
       else {
-        ret = DWARFS_S_LINK_OUTSIDE;
+        tebako_small_path t_path;
+        const char* p_path = to_tebako_path(t_path, lnk.c_str());
+        auto root = sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+        if (p_path == NULL || root == nullptr) {
+          TEBAKO_SET_LAST_ERROR(ENOENT);
+          ret = DWARFS_IO_ERROR;
+        }
+        else if ((ret = root->ensure_loaded()) == DWARFS_IO_CONTINUE) {
+          std::string next_path = p_path[TEBAKO_MOUNT_POINT_LENGTH] == '\0' ? std::string()
+                                                                            : p_path + TEBAKO_MOUNT_POINT_LENGTH + 1;
+          ret = root->find_inode(root->get_root_inode(), next_path, follow, lnk, st);
+        }
       }
     }
   }
@@ -378,19 +517,19 @@ int memfs::find_inode_root(const std::string& path, bool follow, std::string& ln
 //  DWARFS_LINK - symlink or mount point  [lnk is set]
 
 int memfs::process_inode(inode_view& pi,
-                         dwarfs::file_stat* st,
+                         struct stat* st,
                          bool follow,
                          std::string& lnk,
                          stdfs::path::iterator& p_iterator,
                          stdfs::path& p_path)
 {
   int ret = DWARFS_IO_CONTINUE;
-  int err = fs.getattr(pi, st);
+  int err = cached_stat(pi, st);
   if (err == 0) {
     // (1) It is symlink
     // (2a) It is not the last element in the path
     // (2b)   or we should follow the last element  (lstat called)
-    if (S_ISLNK(st->mode) && (++p_iterator != p_path.end() || follow)) {
+    if (S_ISLNK(st->st_mode) && (++p_iterator != p_path.end() || follow)) {
       err = fs.readlink(pi, &lnk);
       if (err == 0) {
         ret = process_link(lnk, p_iterator, p_path);
@@ -444,6 +583,344 @@ int memfs::readlink(const std::string& path, std::string& link, std::string& lnk
   return ret;
 }
 
+// memfs::realpath
+//  Resolves memfs path to the canonical one
+//
+// params
+//  path - lexically normal path starting with the tebako mount point
+//  canonical - out parameter to store the canonical path
+//  lnk - out parameter to store the absolute path to continue from (symlink target or host mount point)
+//
+// returns
+//  DWARFS_IO_CONTINUE - success [canonical is set]
+//  DWARFS_IO_ERROR - error [errno is set]
+//  DWARFS_S_LINK_ABSOLUTE - the path goes through a symlink or a host mount point [lnk is set]
+
+int memfs::realpath(const std::string& path, std::string& canonical, std::string& lnk) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  if (path.length() < TEBAKO_MOUNT_POINT_LENGTH) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+  }
+  else {
+    try {
+      canonical = path.substr(0, TEBAKO_MOUNT_POINT_LENGTH);
+      ret = resolve_path(path.substr(path[TEBAKO_MOUNT_POINT_LENGTH] == '\0' ? TEBAKO_MOUNT_POINT_LENGTH
+                                                                             : TEBAKO_MOUNT_POINT_LENGTH + 1),
+                         canonical, lnk);
+    }
+    catch (...) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+      ret = DWARFS_IO_ERROR;
+    }
+  }
+  return ret;
+}
+
+// memfs::resolve_path
+//  Walks the path once, appending each resolved component to the canonical path
+//  Mount points of other memfs instances are entered directly.
+//  Symlinks (combined with the rest of the path by process_link) and host mount points stop the walk;
+//  they are returned as absolute paths, relative links being resolved against the canonical path of
+//  their directory, which has no symlinks and therefore can be joined lexically
+//
+// params
+//  path - path relative to memfs root
+//  canonical - in: canonical path of memfs root; out: canonical path
+//  lnk - out parameter to store the absolute path to continue from
+//
+// returns
+//  DWARFS_IO_CONTINUE - success [canonical is set]
+//  DWARFS_IO_ERROR - error [errno is set]
+//  DWARFS_S_LINK_ABSOLUTE - restart from lnk [lnk is set]
+
+int memfs::resolve_path(const stdfs::path& path, std::string& canonical, std::string& lnk) noexcept
+{
+  int ret = DWARFS_IO_CONTINUE;
+  try {
+    stdfs::path p_path{path};
+    struct stat i_st;
+    auto& m_table = sync_tebako_mount_table::get_tebako_mount_table();
+    auto pi = fs.find(to_dwarfs_inode(dwarfs_root_inode));
+    if (!pi || cached_stat(*pi, &i_st) != 0) {
+      TEBAKO_SET_LAST_ERROR(ENOENT);
+      return DWARFS_IO_ERROR;
+    }
+
+    auto p_iterator = p_path.begin();
+    while (p_iterator != p_path.end() && ret == DWARFS_IO_CONTINUE) {
+      std::string name = p_iterator->string();
+      if (name.empty() || name == ".") {
+        ++p_iterator;
+        continue;
+      }
+      if (name == "..") {
+        lnk = canonical;
+        ret = process_link(lnk, p_iterator, p_path);
+        break;
+      }
+
+      auto mount_point = m_table.get(pi->inode_num() + get_root_inode(), name);
+      if (mount_point) {
+        if (std::holds_alternative<std::string>(*mount_point)) {
+          lnk = std::get<std::string>(*mount_point);
+          ret = process_link(lnk, ++p_iterator, p_path);
+        }
+        else {
+          stdfs::path next_path = stdfs::path("");
+          while (++p_iterator != p_path.end()) {
+            next_path /= p_iterator->string();
+          }
+          uint32_t index = std::holds_alternative<uint32_t>(*mount_point)
+                               ? std::get<uint32_t>(*mount_point)
+                               : std::get<std::shared_ptr<memfs_overlay>>(*mount_point)->resolve(next_path);
+          auto next_memfs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(index);
+          if (next_memfs == nullptr) {
+            TEBAKO_SET_LAST_ERROR(ENOENT);
+            return DWARFS_IO_ERROR;
+          }
+          if (next_memfs->ensure_loaded() != DWARFS_IO_CONTINUE) {
+            return DWARFS_IO_ERROR;
+          }
+          canonical += '/';
+          canonical += name;
+          return next_memfs->resolve_path(next_path, canonical, lnk);
+        }
+      }
+      else if (!S_ISDIR(i_st.st_mode)) {
+        TEBAKO_SET_LAST_ERROR(ENOTDIR);
+        ret = DWARFS_IO_ERROR;
+      }
+      else if (!(pi = fs.find(pi->inode_num(), name.c_str()))) {
+        TEBAKO_SET_LAST_ERROR(ENOENT);
+        ret = DWARFS_IO_ERROR;
+      }
+      else {
+        int err = cached_stat(*pi, &i_st);
+        if (err == 0 && S_ISLNK(i_st.st_mode)) {
+          err = fs.readlink(*pi, &lnk);
+          if (err == 0) {
+            ret = process_link(lnk, ++p_iterator, p_path);
+          }
+        }
+        else if (err == 0) {
+          canonical += '/';
+          canonical += name;
+          ++p_iterator;
+        }
+        if (err != 0) {
+          TEBAKO_SET_LAST_ERROR(-err);
+          ret = DWARFS_IO_ERROR;
+        }
+      }
+    }
+
+    if (ret == DWARFS_S_LINK_RELATIVE) {
+      lnk = (stdfs::path(canonical) / lnk).lexically_normal().generic_string();
+      ret = DWARFS_S_LINK_ABSOLUTE;
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = DWARFS_IO_ERROR;
+  }
+  return ret;
+}
+
+// memfs::dir_entries
+//  Calls fn for each entry of the directory except "." and ".."
+//  Unlike list_dir it neither reads link targets nor computes data ranks
+int memfs::dir_entries(tebako_ino_t inode,
+                       std::function<void(const std::string& name, const struct stat& st)> const& fn) noexcept
+{
+  int ret = ensure_loaded();
+  if (ret == DWARFS_IO_CONTINUE) {
+    try {
+      auto pi = fs.find(to_dwarfs_inode(inode));
+      auto dir = pi ? fs.opendir(*pi) : std::nullopt;
+      if (!dir) {
+        TEBAKO_SET_LAST_ERROR(pi ? ENOTDIR : ENOENT);
+        return DWARFS_IO_ERROR;
+      }
+      size_t dir_size = fs.dirsize(*dir);
+      for (size_t i = 0; i < dir_size; ++i) {
+        auto res = fs.readdir(*dir, i);
+        if (!res) {
+          break;
+        }
+        auto [iv, name_view] = *res;
+        std::string name(name_view);
+        if (name == "." || name == "..") {
+          continue;
+        }
+        struct stat st;
+        if (dwarfs_file_stat(iv, &st) != DWARFS_IO_CONTINUE) {
+          return DWARFS_IO_ERROR;
+        }
+        fn(name, st);
+      }
+    }
+    catch (dwarfs::system_error const& e) {
+      TEBAKO_SET_LAST_ERROR(e.get_errno());
+      ret = DWARFS_IO_ERROR;
+    }
+    catch (...) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+      ret = DWARFS_IO_ERROR;
+    }
+  }
+  return ret;
+}
+
+// memfs::list_tree
+//  Lists the subtree starting at inode (directory before its content)
+//  Only the subtree is traversed, not the whole image
+//  Regular files are tagged with data rank, so that the caller can process them
+//  in the order of data blocks
+int memfs::list_tree(tebako_ino_t inode, std::vector<memfs_tree_entry>& entries) noexcept
+{
+  int ret = ensure_loaded();
+  if (ret == DWARFS_IO_CONTINUE) {
+    try {
+      auto pi = fs.find(to_dwarfs_inode(inode));
+      if (!pi) {
+        TEBAKO_SET_LAST_ERROR(ENOENT);
+        return DWARFS_IO_ERROR;
+      }
+
+      // Children are pushed in reverse order, so that they are listed in directory order
+      std::vector<std::pair<dwarfs::inode_view, std::string>> pending;
+      pending.emplace_back(*pi, std::string());
+      while (!pending.empty()) {
+        auto [iv, path] = std::move(pending.back());
+        pending.pop_back();
+
+        memfs_tree_entry e{std::move(path), {}, {}, no_data_rank};
+        if (dwarfs_file_stat(iv, &e.st) != DWARFS_IO_CONTINUE) {
+          return DWARFS_IO_ERROR;
+        }
+        if (S_ISLNK(e.st.st_mode)) {
+          int res = fs.readlink(iv, &e.link);
+          if (res < 0) {
+            TEBAKO_SET_LAST_ERROR(-res);
+            return DWARFS_IO_ERROR;
+          }
+        }
+        else if (S_ISREG(e.st.st_mode)) {
+          e.data_rank = inode_data_rank(e.st.st_ino);
+        }
+        else if (S_ISDIR(e.st.st_mode)) {
+          auto dir = fs.opendir(iv);
+          if (dir) {
+            for (size_t i = fs.dirsize(*dir); i-- > 0;) {
+              auto res = fs.readdir(*dir, i);
+              if (!res) {
+                continue;
+              }
+              auto [child, name_view] = *res;
+              std::string name(name_view);
+              if (name == "." || name == "..") {
+                continue;
+              }
+              pending.emplace_back(child, e.path.empty() ? name : e.path + '/' + name);
+            }
+          }
+        }
+        entries.push_back(std::move(e));
+      }
+    }
+    catch (dwarfs::system_error const& e) {
+      TEBAKO_SET_LAST_ERROR(e.get_errno());
+      ret = DWARFS_IO_ERROR;
+    }
+    catch (...) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+      ret = DWARFS_IO_ERROR;
+    }
+  }
+  return ret;
+}
+
+// memfs::inode_data_rank
+//  Returns the position of inode data in the image (no_data_rank if inode has no data or on error)
+//  Reading files in the ascending order of data rank decompresses each block once
+uint32_t memfs::inode_data_rank(tebako_ino_t inode) noexcept
+{
+  try {
+    std::call_once(data_ranks_flag, [this]() {
+      std::vector<uint32_t> ranks;
+      uint32_t rank = 0;
+      fs.walk_data_order([&ranks, &rank](dir_entry_view entry) {
+        uint32_t ino = entry.inode().inode_num();
+        if (ino >= ranks.size()) {
+          ranks.resize(ino + 1, no_data_rank);
+        }
+        if (ranks[ino] == no_data_rank) {
+          ranks[ino] = rank++;
+        }
+      });
+      data_ranks = std::move(ranks);
+    });
+  }
+  catch (...) {
+    return no_data_rank;
+  }
+  uint32_t ino = to_dwarfs_inode(inode);
+  return ino < data_ranks.size() ? data_ranks[ino] : no_data_rank;
+}
+
+// memfs::list_dir
+//  Lists directory content (entry path is the file name)
+int memfs::list_dir(tebako_ino_t inode, std::vector<memfs_tree_entry>& entries) noexcept
+{
+  int ret = ensure_loaded();
+  if (ret == DWARFS_IO_CONTINUE) {
+    try {
+      auto pi = fs.find(to_dwarfs_inode(inode));
+      auto dir = pi ? fs.opendir(*pi) : std::nullopt;
+      if (!dir) {
+        TEBAKO_SET_LAST_ERROR(pi ? ENOTDIR : ENOENT);
+        return DWARFS_IO_ERROR;
+      }
+      size_t dir_size = fs.dirsize(*dir);
+      for (size_t i = 0; i < dir_size; ++i) {
+        auto res = fs.readdir(*dir, i);
+        if (!res) {
+          break;
+        }
+        auto [iv, name] = *res;
+        if (name == "." || name == "..") {
+          continue;
+        }
+        memfs_tree_entry e{std::string(name), {}, {}, no_data_rank};
+        if (dwarfs_file_stat(iv, &e.st) != DWARFS_IO_CONTINUE) {
+          return DWARFS_IO_ERROR;
+        }
+        if (S_ISLNK(e.st.st_mode)) {
+          int rc = fs.readlink(iv, &e.link);
+          if (rc < 0) {
+            TEBAKO_SET_LAST_ERROR(-rc);
+            return DWARFS_IO_ERROR;
+          }
+        }
+        else if (S_ISREG(e.st.st_mode)) {
+          e.data_rank = inode_data_rank(e.st.st_ino);
+        }
+        entries.push_back(std::move(e));
+      }
+    }
+    catch (dwarfs::system_error const& e) {
+      TEBAKO_SET_LAST_ERROR(e.get_errno());
+      ret = DWARFS_IO_ERROR;
+    }
+    catch (...) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+      ret = DWARFS_IO_ERROR;
+    }
+  }
+  return ret;
+}
+
 int memfs::access(const std::string& path, int amode, uid_t uid, gid_t gid, std::string& lnk) noexcept
 {
   struct stat st;
@@ -456,13 +933,8 @@ int memfs::access(const std::string& path, int amode, uid_t uid, gid_t gid, std:
 
 int memfs::dwarfs_file_stat(inode_view& inode, struct stat* st)
 {
-  dwarfs::file_stat dwarfs_file_stat;
-  int ret = fs.getattr(inode, &dwarfs_file_stat);
-#if defined(_WIN32)
-  copy_file_stat<false>(st, dwarfs_file_stat);
-#else
-  copy_file_stat<true>(st, dwarfs_file_stat);
-#endif
+  int ret = cached_stat(inode, st);
+  st->st_ino = to_tebako_inode(st->st_ino);
   if (ret < 0) {
     TEBAKO_SET_LAST_ERROR(-ret);
     ret = DWARFS_IO_ERROR;
@@ -470,10 +942,51 @@ int memfs::dwarfs_file_stat(inode_view& inode, struct stat* st)
   return ret;
 }
 
-int memfs::inode_access(uint32_t inode, int amode, uid_t uid, gid_t gid) noexcept
+// memfs::cached_stat
+//  Gets inode attributes from the stat cache, the slot is filled by the first request
+//  st_ino is dwarfs inode number, not the composite one
+//
+// returns
+//  0 - success [st is filled]
+//  -errno - error, as dwarfs getattr does
+int memfs::cached_stat(inode_view& inode, struct stat* st)
+{
+  uint32_t ino = inode.inode_num();
+  const struct stat* cached = stat_cache.get(ino);
+  if (cached != nullptr) {
+    *st = *cached;
+    return 0;
+  }
+  dwarfs::file_stat dwarfs_st;
+  int ret = fs.getattr(inode, &dwarfs_st);
+#if defined(_WIN32)
+  copy_file_stat<false>(st, dwarfs_st);
+#else
+  copy_file_stat<true>(st, dwarfs_st);
+#endif
+  if (ret == 0) {
+    stat_cache.put(ino, *st);
+  }
+  return ret;
+}
+
+// memfs::to_dwarfs_inode, memfs::to_tebako_inode
+//  Conversion between composite inode number [ memfs index | dwarfs inode ] that is
+//  exposed via st_ino and used by the mount table and inode number known to dwarfs
+uint32_t memfs::to_dwarfs_inode(tebako_ino_t inode) const
+{
+  return static_cast<uint32_t>(sync_tebako_memfs_table::getFsIno(inode));
+}
+
+tebako_ino_t memfs::to_tebako_inode(tebako_ino_t inode) const
+{
+  return dwarfs_root_inode | sync_tebako_memfs_table::getFsIno(inode);
+}
+
+int memfs::inode_access(tebako_ino_t inode, int amode, uid_t uid, gid_t gid) noexcept
 {
   int ret = DWARFS_IO_ERROR;
-  auto pi = fs.find(inode);
+  auto pi = fs.find(to_dwarfs_inode(inode));
   if (pi) {
     struct stat st;
     ret = dwarfs_file_stat(*pi, &st);
@@ -487,10 +1000,98 @@ int memfs::inode_access(uint32_t inode, int amode, uid_t uid, gid_t gid) noexcep
   return ret;
 }
 
-ssize_t memfs::inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept
+// memfs::disk_cached_file
+//  Returns the content of the file from the persistent cache
+//  The file is decompressed and stored to the cache on the first request
+std::shared_ptr<const disk_cache_entry> memfs::disk_cached_file(tebako_ino_t inode) noexcept
+{
+  uint32_t ino = to_dwarfs_inode(inode);
+  bool cacheable = false;
+  auto cached = dcache->get(ino, cacheable);
+  if (cached || !cacheable) {
+    return cached;
+  }
+
+  try {
+    struct stat st;
+    auto iv = fs.find(ino);
+    if (!iv || dwarfs_file_stat(*iv, &st) != DWARFS_IO_CONTINUE || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        static_cast<size_t>(st.st_size) > dcache->max_entry_size()) {
+      dcache->reject(ino);
+      return nullptr;
+    }
+    std::vector<char> content(static_cast<size_t>(st.st_size));
+    if (fs.read(ino, content.data(), content.size(), 0) != static_cast<ssize_t>(content.size())) {
+      dcache->reject(ino);
+      return nullptr;
+    }
+    return dcache->put(ino, content.data(), content.size());
+  }
+  catch (...) {
+    dcache->reject(ino);
+    return nullptr;
+  }
+}
+
+// memfs::shared_cached_read
+//  Reads the file from the cache shared with forked processes
+//  The file is stored to the cache on the first request
+//
+// returns
+//  number of bytes read
+//  shared_cache::miss or shared_cache::not_cacheable - the file shall be read elsewhere
+ssize_t memfs::shared_cached_read(tebako_ino_t inode, void* buf, size_t size, off_t offset) noexcept
+{
+  uint32_t ino = to_dwarfs_inode(inode);
+  ssize_t ret = scache->read(ino, buf, size, offset);
+  if (ret != shared_cache::miss) {
+    return ret;
+  }
+
+  try {
+    std::shared_ptr<const disk_cache_entry> cached = dcache ? disk_cached_file(inode) : nullptr;
+    if (cached) {
+      scache->put(ino, cached->data(), cached->size());
+    }
+    else {
+      struct stat st;
+      auto iv = fs.find(ino);
+      if (!iv || dwarfs_file_stat(*iv, &st) != DWARFS_IO_CONTINUE || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+          static_cast<size_t>(st.st_size) > scache->max_entry_size()) {
+        scache->reject(ino);
+        return shared_cache::not_cacheable;
+      }
+      std::vector<char> content(static_cast<size_t>(st.st_size));
+      if (fs.read(ino, content.data(), content.size(), 0) == static_cast<ssize_t>(content.size())) {
+        scache->put(ino, content.data(), content.size());
+      }
+    }
+  }
+  catch (...) {
+    return shared_cache::miss;
+  }
+  return scache->read(ino, buf, size, offset);
+}
+
+ssize_t memfs::inode_read(tebako_ino_t inode, void* buf, size_t size, off_t offset) noexcept
 {
   int ret = DWARFS_IO_ERROR;
-  int err = fs.read(inode, static_cast<char*>(buf), size, offset);
+  if (scache && offset >= 0) {
+    ssize_t n = shared_cached_read(inode, buf, size, offset);
+    if (n >= 0) {
+      return n;
+    }
+  }
+  if (dcache && offset >= 0) {
+    auto cached = disk_cached_file(inode);
+    if (cached) {
+      size_t start = std::min(static_cast<size_t>(offset), cached->size());
+      size_t n = std::min(size, cached->size() - start);
+      memcpy(buf, cached->data() + start, n);
+      return static_cast<ssize_t>(n);
+    }
+  }
+  int err = fs.read(to_dwarfs_inode(inode), static_cast<char*>(buf), size, offset);
   if (err < 0) {
     TEBAKO_SET_LAST_ERROR(-err);
   }
@@ -500,7 +1101,7 @@ ssize_t memfs::inode_read(uint32_t inode, void* buf, size_t size, off_t offset)
   return ret;
 }
 
-int memfs::inode_readdir(uint32_t inode,
+int memfs::inode_readdir(tebako_ino_t inode,
                          tebako_dirent* cache,
                          off_t cache_start,
                          size_t buffer_size,
@@ -508,7 +1109,7 @@ int memfs::inode_readdir(uint32_t inode,
                          size_t& dir_size) noexcept
 {
   int ret = -1;
-  auto pi = fs.find(inode);
+  auto pi = fs.find(to_dwarfs_inode(inode));
   if (pi) {
     auto dir = fs.opendir(*pi);
     if (dir) {
@@ -526,42 +1127,7 @@ int memfs::inode_readdir(uint32_t inode,
           std::string name(std::move(name_view));
           struct stat st;
           ret = dwarfs_file_stat(entry, &st);
-
-#ifndef RB_W32
-          cache[cache_size].e.d_ino = st.st_ino;
-#if __MACH__
-          cache[cache_size].e.d_seekoff = cache_start + cache_size;
-#else
-          cache[cache_size].e.d_off = cache_start + cache_size;
-#endif
-          cache[cache_size].e.d_type = IFTODT(st.st_mode);
-          strncpy(cache[cache_size]._e.d_name, name.c_str(), TEBAKO_PATH_LENGTH);
-          cache[cache_size]._e.d_name[TEBAKO_PATH_LENGTH] = '\0';
-          cache[cache_size].e.d_reclen = sizeof(cache[0]);
-#else
-#ifdef _WIN32
-          cache[cache_size].e.d_altname = 0;
-          cache[cache_size].e.d_altlen = 0;
-          cache[cache_size].e.d_name = cache[cache_size].d_name;
-          if (S_ISDIR(st.st_mode)) {
-            cache[cache_size].e.d_type = DT_DIR;
-          }
-          else if (S_ISLNK(st.st_mode)) {
-            cache[cache_size].e.d_type = DT_LNK;
-          }
-          else {
-            cache[cache_size].e.d_type = DT_REG;
-          }
-          cache[cache_size].e.d_namlen = std::min(name.length(), TEBAKO_PATH_LENGTH - 1);
-#else
-          cache[cache_size].e.d_reclen = 0;
-          cache[cache_size].e.d_namlen = std::min(name.length(), sizeof(cache[cache_size].e.d_name) - 1);
-#endif
-          static int dummy = INT_MAX;
-          cache[cache_size].e.d_ino = dummy--;
-          strncpy(cache[cache_size].e.d_name, name.c_str(), cache[cache_size].e.d_namlen);
-          cache[cache_size].e.d_name[cache[cache_size].e.d_namlen] = '\0';
-#endif
+          fill_dirent(cache[cache_size], name, st, cache_start + cache_size);
           ++cache_size;
         }
       }
@@ -577,10 +1143,10 @@ int memfs::inode_readdir(uint32_t inode,
   return ret;
 }
 
-int memfs::inode_readlink(uint32_t inode, std::string& lnk) noexcept
+int memfs::inode_readlink(tebako_ino_t inode, std::string& lnk) noexcept
 {
   int ret = DWARFS_IO_ERROR;
-  auto pi = fs.find(inode);
+  auto pi = fs.find(to_dwarfs_inode(inode));
   if (pi) {
     int err = fs.readlink(*pi, &lnk);
     if (err < 0) {
@@ -612,33 +1178,4 @@ int memfs::i_access(int amode, struct stat* st)
   return ret;
 }
 
-template <typename Functor, class... Args>
-int memfs::safe_dwarfs_call(Functor&& fn, const char* caller, uint32_t inode, Args&&... args)
-{
-  int ret = DWARFS_IO_ERROR;
-  int err = ENOENT;
-  if (options().debuglevel >= logger::DEBUG) {
-    LOG_PROXY(debug_logger_policy, logger());
-    LOG_DEBUG << caller << " [ " << inode << " ]";
-  }
-  try {
-    ret = fn(inode, std::forward<Args>(args)...);
-    if (ret < 0) {
-      err = ret;
-      ret = DWARFS_IO_ERROR;
-    }
-  }
-  catch (dwarfs::system_error const& e) {
-    err = e.get_errno();
-    ret = DWARFS_IO_ERROR;
-  }
-  catch (...) {
-    err = EIO;
-    ret = DWARFS_IO_ERROR;
-  }
-  if (ret < DWARFS_IO_CONTINUE) {
-    TEBAKO_SET_LAST_ERROR(err < 0 ? -err : err);
-  }
-  return ret;
-}
 }  // namespace tebako
@@ -29,8 +29,11 @@
 
 #include <tebako-pch.h>
 #include <tebako-pch-pp.h>
+#include <tebako-common.h>
 
+#include <tebako-io-inner.h>
 #include <tebako-mount-table.h>
+#include <tebako-memfs-overlay.h>
 
 namespace tebako {
 sync_tebako_mount_table& sync_tebako_mount_table::get_tebako_mount_table(void)
@@ -50,12 +53,21 @@ void sync_tebako_mount_table::clear(void)
 {
   auto p_mount_table = s_tebako_mount_table.wlock();
   p_mount_table->clear();
+  overlays.store(0, std::memory_order_release);
+  generation.fetch_add(1, std::memory_order_acq_rel);
 }
 
 void sync_tebako_mount_table::erase(const tebako_mount_point& mount_point)
 {
   auto p_mount_table = s_tebako_mount_table.wlock();
-  p_mount_table->erase(mount_point);
+  auto p_mount = p_mount_table->find(mount_point);
+  if (p_mount != p_mount_table->end()) {
+    if (std::holds_alternative<std::shared_ptr<memfs_overlay>>(p_mount->second)) {
+      overlays.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    p_mount_table->erase(p_mount);
+  }
+  generation.fetch_add(1, std::memory_order_acq_rel);
 }
 
 std::optional<tebako_mount_target> sync_tebako_mount_table::get(const tebako_mount_point& mount_point)
@@ -71,13 +83,44 @@ std::optional<tebako_mount_target> sync_tebako_mount_table::get(const tebako_mou
 bool sync_tebako_mount_table::insert(const tebako_mount_point& mount_point, const std::string& mount_target)
 {
   auto p_mount_table = s_tebako_mount_table.wlock();
+  generation.fetch_add(1, std::memory_order_acq_rel);
   return p_mount_table->emplace(mount_point, mount_target).second;
 }
 
 bool sync_tebako_mount_table::insert(const tebako_mount_point& mount_point, uint32_t mount_target)
 {
   auto p_mount_table = s_tebako_mount_table.wlock();
+  generation.fetch_add(1, std::memory_order_acq_rel);
   return p_mount_table->emplace(mount_point, mount_target).second;
 }
 
+bool sync_tebako_mount_table::insert(const tebako_mount_point& mount_point,
+                                     std::shared_ptr<memfs_overlay> mount_target)
+{
+  auto p_mount_table = s_tebako_mount_table.wlock();
+  generation.fetch_add(1, std::memory_order_acq_rel);
+  bool ret = p_mount_table->emplace(mount_point, std::move(mount_target)).second;
+  if (ret) {
+    overlays.fetch_add(1, std::memory_order_acq_rel);
+  }
+  return ret;
+}
+
+std::shared_ptr<memfs_overlay> sync_tebako_mount_table::get_merged_dir_overlay(tebako_ino_t inode)
+{
+  if (overlays.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+  auto p_mount_table = s_tebako_mount_table.rlock();
+  for (auto& mount : *p_mount_table) {
+    if (std::holds_alternative<std::shared_ptr<memfs_overlay>>(mount.second)) {
+      auto& overlay = std::get<std::shared_ptr<memfs_overlay>>(mount.second);
+      if (overlay->is_merged_dir(inode)) {
+        return overlay;
+      }
+    }
+  }
+  return nullptr;
+}
+
 }  // namespace tebako
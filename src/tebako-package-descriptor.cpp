@@ -33,6 +33,7 @@
 namespace tebako {
 
 const char* package_descriptor::signature = "TAMATEBAKO";
+const char* package_descriptor::dl_prefetch_signature = "TEBAKODLPF";
 
 // Constructor for deserialization
 package_descriptor::package_descriptor(const std::vector<char>& buffer)
@@ -96,6 +97,23 @@ package_descriptor::package_descriptor(const std::vector<char>& buffer)
   else {
     cwd.reset();
   }
+
+  // Optional list of shared objects to prefetch, absent in older packages
+  // The descriptor is followed by filesystem image, so the list is recognized by its signature
+  size_t dl_prefetch_signature_length = std::strlen(dl_prefetch_signature);
+  if (offset + dl_prefetch_signature_length <= buffer.size() &&
+      std::memcmp(buffer.data() + offset, dl_prefetch_signature, dl_prefetch_signature_length) == 0) {
+    offset += dl_prefetch_signature_length;
+    uint16_t dl_prefetch_count;
+    read_from_buffer(&dl_prefetch_count, sizeof(dl_prefetch_count));
+    for (uint16_t i = 0; i < dl_prefetch_count; ++i) {
+      uint16_t dl_size;
+      read_from_buffer(&dl_size, sizeof(dl_size));
+      std::string dl(dl_size, '\0');
+      read_from_buffer(dl.data(), dl_size);
+      dl_prefetch.push_back(std::move(dl));
+    }
+  }
 }
 
 // Constructor from version strings and other parameters
@@ -103,8 +121,9 @@ package_descriptor::package_descriptor(const std::string& ruby_version,
                                        const std::string& tebako_version,
                                        const std::string& mount_point,
                                        const std::string& entry_point,
-                                       const std::optional<std::string>& cwd)
-    : mount_point(mount_point), entry_point(entry_point), cwd(cwd)
+                                       const std::optional<std::string>& cwd,
+                                       const std::vector<std::string>& dl_prefetch)
+    : mount_point(mount_point), entry_point(entry_point), cwd(cwd), dl_prefetch(dl_prefetch)
 {
   auto parse_version = [](const std::string& version, uint16_t& major, uint16_t& minor, uint16_t& patch) {
     std::stringstream ss(version);
@@ -156,6 +175,18 @@ std::vector<char> package_descriptor::serialize() const
     append_to_buffer(cwd->data(), cwd_size);
   }
 
+  // Append the list of shared objects to prefetch (only if there are any, to keep the format of older packages)
+  if (!dl_prefetch.empty()) {
+    append_to_buffer(dl_prefetch_signature, std::strlen(dl_prefetch_signature));
+    uint16_t dl_prefetch_count = static_cast<uint16_t>(dl_prefetch.size());
+    append_to_buffer(&dl_prefetch_count, sizeof(dl_prefetch_count));
+    for (const auto& dl : dl_prefetch) {
+      uint16_t dl_size = static_cast<uint16_t>(dl.size());
+      append_to_buffer(&dl_size, sizeof(dl_size));
+      append_to_buffer(dl.data(), dl_size);
+    }
+  }
+
   return buffer;
 }
 
@@ -0,0 +1,371 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+
+#include <folly/hash/Checksum.h>
+#include <folly/portability/SysMman.h>
+
+#include <tebako-shared-cache.h>
+
+namespace tebako {
+
+// Slot state word
+// [ inode (32 bits) | epoch / 2 (30 bits) | tag (2 bits) ], 0 - empty slot
+namespace {
+constexpr uint64_t tag_mask = 0x3;
+constexpr uint64_t tag_writing = 0x1;
+constexpr uint64_t tag_ready = 0x2;
+constexpr uint64_t tag_rejected = 0x3;
+constexpr uint64_t epoch_mask = 0xFFFFFFFC;
+
+constexpr uint64_t writers_count_mask = 0xFFFFFFFF;
+
+constexpr size_t max_probes = 64;
+constexpr size_t bytes_per_slot = static_cast<size_t>(16) << 10;
+constexpr size_t min_slots = 256;
+constexpr size_t alignment = 64;
+
+uint64_t make_key(uint32_t inode, uint64_t epoch)
+{
+  return (static_cast<uint64_t>(inode) << 32) | (((epoch >> 1) << 2) & epoch_mask);
+}
+
+size_t align_up(size_t v)
+{
+  return (v + alignment - 1) & ~(alignment - 1);
+}
+
+uint64_t make_writers(uint64_t epoch, uint64_t count)
+{
+  return ((epoch & writers_count_mask) << 32) | count;
+}
+
+// A writer that does not finish within this time is assumed to be dead
+constexpr auto flush_timeout = std::chrono::seconds(1);
+}  // namespace
+
+struct shared_cache::region_header {
+  uint64_t slot_count;
+  uint64_t data_size;
+  std::atomic<uint64_t> epoch;  // odd while the cache is being flushed
+  std::atomic<uint64_t> data_used;
+  std::atomic<uint64_t> writers;  // [ epoch (32 bits) | writers of this epoch (32 bits) ]
+};
+
+struct shared_cache::slot {
+  std::atomic<uint64_t> state;
+  std::atomic<uint64_t> offset;
+  std::atomic<uint64_t> size;
+  std::atomic<uint32_t> crc;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared cache requires lock-free 64-bit atomics");
+
+shared_cache::shared_cache(size_t size, size_t max_entry_size)
+    : region(nullptr),
+      region_size(0),
+      max_entry_size_(max_entry_size),
+      header(nullptr),
+      slots(nullptr),
+      data_area(nullptr)
+{
+#ifndef _WIN32
+  size_t slot_count = min_slots;
+  while (slot_count < size / bytes_per_slot) {
+    slot_count <<= 1;
+  }
+  size_t slots_start = align_up(sizeof(region_header));
+  size_t data_start = align_up(slots_start + slot_count * sizeof(slot));
+  if (size < data_start + max_entry_size) {
+    return;
+  }
+
+  void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    return;
+  }
+
+  region = map;
+  region_size = size;
+  char* base = static_cast<char*>(map);
+  header = new (base) region_header{slot_count, size - data_start, {0}, {0}, {make_writers(0, 0)}};
+  slots = reinterpret_cast<slot*>(base + slots_start);
+  for (size_t i = 0; i < slot_count; ++i) {
+    new (&slots[i]) slot{{0}, {0}, {0}, {0}};
+  }
+  data_area = base + data_start;
+#endif
+}
+
+shared_cache::~shared_cache()
+{
+  if (region != nullptr) {
+    ::munmap(region, region_size);
+  }
+}
+
+uint64_t shared_cache::epoch() const
+{
+  return header != nullptr ? header->epoch.load(std::memory_order_acquire) : 0;
+}
+
+// shared_cache::find_slot
+//  Looks up the slot of inode in the epoch
+//  If tag is not zero and there is no such slot, claims a free one with this tag [claimed is set to true]
+shared_cache::slot* shared_cache::find_slot(uint32_t inode, uint64_t epoch, uint64_t tag, bool& claimed) noexcept
+{
+  uint64_t key = make_key(inode, epoch);
+  size_t mask = header->slot_count - 1;
+  size_t i = static_cast<size_t>((inode * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+  claimed = false;
+
+  for (size_t probe = 0; probe < max_probes;) {
+    slot& s = slots[i];
+    uint64_t state = s.state.load(std::memory_order_acquire);
+    if ((state & ~tag_mask) == key) {
+      return &s;
+    }
+
+    // Slots of the previous epochs are left by the writers interrupted by flush
+    // They are free as well as the empty ones, but do not terminate the lookup
+    bool is_free = (state == 0 || (state & epoch_mask) != (key & epoch_mask));
+    if (is_free && tag == 0 && state == 0) {
+      return nullptr;
+    }
+    if (is_free && tag != 0) {
+      if (s.state.compare_exchange_strong(state, key | tag, std::memory_order_acq_rel)) {
+        claimed = true;
+        return &s;
+      }
+      continue;  // The slot has been changed by somebody else, look at it again
+    }
+    ++probe;
+    i = (i + 1) & mask;
+  }
+  return nullptr;
+}
+
+// shared_cache::begin_write
+//  Registers a writer of the epoch, so that flush does not reuse the data area under it
+//  Fails if the epoch is over
+bool shared_cache::begin_write(uint64_t epoch) noexcept
+{
+  uint64_t writers = header->writers.load(std::memory_order_acquire);
+  do {
+    if ((writers >> 32) != (epoch & writers_count_mask)) {
+      return false;
+    }
+  } while (!header->writers.compare_exchange_weak(writers, writers + 1, std::memory_order_acq_rel));
+
+  // Flush might have started before the writer was registered
+  if (header->epoch.load(std::memory_order_acquire) != epoch) {
+    end_write(epoch);
+    return false;
+  }
+  return true;
+}
+
+// shared_cache::end_write
+//  Unregisters a writer of the epoch; does nothing if flush has completed without waiting for it
+void shared_cache::end_write(uint64_t epoch) noexcept
+{
+  uint64_t writers = header->writers.load(std::memory_order_acquire);
+  do {
+    if ((writers >> 32) != (epoch & writers_count_mask) || (writers & writers_count_mask) == 0) {
+      return;
+    }
+  } while (!header->writers.compare_exchange_weak(writers, writers - 1, std::memory_order_acq_rel));
+}
+
+// shared_cache::flush
+//  Drops all entries of the epoch; does nothing if the epoch is over already
+//  The data area is reused only after the writers of the epoch have finished copying, otherwise
+//  a late writer could overwrite the entries of the next epoch. A process that died in the middle
+//  of put never finishes, so the wait is limited by flush_timeout
+void shared_cache::flush(uint64_t epoch) noexcept
+{
+  uint64_t expected = epoch;
+  if (header->epoch.compare_exchange_strong(expected, epoch + 1, std::memory_order_acq_rel)) {
+    auto deadline = std::chrono::steady_clock::now() + flush_timeout;
+    while ((header->writers.load(std::memory_order_acquire) & writers_count_mask) != 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < header->slot_count; ++i) {
+      slots[i].state.store(0, std::memory_order_relaxed);
+    }
+    header->data_used.store(0, std::memory_order_relaxed);
+    header->writers.store(make_writers(epoch + 2, 0), std::memory_order_relaxed);
+    header->epoch.store(epoch + 2, std::memory_order_release);
+  }
+}
+
+// shared_cache::validate
+//  Verifies the checksum of entry once per process and epoch
+bool shared_cache::validate(uint32_t inode, uint64_t epoch, uint64_t offset, uint64_t size, uint32_t crc) noexcept
+{
+  try {
+    {
+      auto locked = validated.rlock();
+      auto it = locked->find(inode);
+      if (it != locked->end() && it->second == epoch) {
+        return true;
+      }
+    }
+    if (folly::crc32c(reinterpret_cast<const uint8_t*>(data_area + offset), size) != crc ||
+        header->epoch.load(std::memory_order_acquire) != epoch) {
+      return false;
+    }
+    (*validated.wlock())[inode] = epoch;
+    return true;
+  }
+  catch (...) {
+    return false;
+  }
+}
+
+// shared_cache::read
+//  Copies [offset, offset + size) of the cached file to buf
+//
+// returns
+//  number of bytes copied
+//  miss - the file is not cached [yet]
+//  not_cacheable - the file has been rejected
+ssize_t shared_cache::read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept
+{
+  if (header == nullptr) {
+    return not_cacheable;
+  }
+
+  uint64_t epoch = header->epoch.load(std::memory_order_acquire);
+  if (epoch & 1) {
+    return miss;
+  }
+
+  bool claimed;
+  slot* s = find_slot(inode, epoch, 0, claimed);
+  if (s == nullptr) {
+    return miss;
+  }
+  uint64_t state = s->state.load(std::memory_order_acquire);
+  if ((state & ~tag_mask) != make_key(inode, epoch)) {
+    return miss;
+  }
+  if ((state & tag_mask) == tag_rejected) {
+    return not_cacheable;
+  }
+  if ((state & tag_mask) != tag_ready) {
+    return miss;
+  }
+
+  uint64_t e_offset = s->offset.load(std::memory_order_relaxed);
+  uint64_t e_size = s->size.load(std::memory_order_relaxed);
+  uint32_t e_crc = s->crc.load(std::memory_order_relaxed);
+  if (e_offset > header->data_size || e_size > header->data_size - e_offset ||
+      !validate(inode, epoch, e_offset, e_size, e_crc)) {
+    return miss;
+  }
+
+  size_t start = static_cast<size_t>(std::min(static_cast<uint64_t>(offset), e_size));
+  size_t n = static_cast<size_t>(std::min(static_cast<uint64_t>(size), e_size - start));
+  memcpy(buf, data_area + e_offset + start, n);
+
+  // The entry might be dropped by flush while it was copied
+  if (header->epoch.load(std::memory_order_acquire) != epoch) {
+    return miss;
+  }
+  return static_cast<ssize_t>(n);
+}
+
+// shared_cache::put
+//  Stores the file content
+//  If there is no room for it, the cache is flushed and the file is not stored
+//  The writer is registered for the time it copies data, see flush
+bool shared_cache::put(uint32_t inode, const void* data, size_t size) noexcept
+{
+  if (header == nullptr) {
+    return false;
+  }
+  if (size == 0 || size > max_entry_size_) {
+    reject(inode);
+    return false;
+  }
+
+  uint64_t epoch = header->epoch.load(std::memory_order_acquire);
+  if ((epoch & 1) || !begin_write(epoch)) {
+    return false;
+  }
+
+  bool ret = false;
+  bool full = false;
+  bool claimed;
+  slot* s = find_slot(inode, epoch, tag_writing, claimed);
+  if (s == nullptr) {
+    full = true;  // Index is full
+  }
+  else if (claimed) {  // Otherwise stored or being stored by another process
+    uint64_t aligned = align_up(size);
+    uint64_t offset = header->data_used.fetch_add(aligned, std::memory_order_relaxed);
+    if (offset + aligned > header->data_size) {
+      full = true;  // Data budget is exhausted
+    }
+    else {
+      memcpy(data_area + offset, data, size);
+      s->offset.store(offset, std::memory_order_relaxed);
+      s->size.store(size, std::memory_order_relaxed);
+      s->crc.store(folly::crc32c(static_cast<const uint8_t*>(data), size), std::memory_order_relaxed);
+
+      uint64_t key = make_key(inode, epoch);
+      uint64_t expected = key | tag_writing;
+      ret = s->state.compare_exchange_strong(expected, key | tag_ready, std::memory_order_release,
+                                             std::memory_order_relaxed);
+    }
+  }
+  end_write(epoch);
+
+  if (full) {
+    flush(epoch);
+  }
+  return ret;
+}
+
+void shared_cache::reject(uint32_t inode) noexcept
+{
+  if (header != nullptr) {
+    uint64_t epoch = header->epoch.load(std::memory_order_acquire);
+    if ((epoch & 1) == 0) {
+      bool claimed;
+      find_slot(inode, epoch, tag_rejected, claimed);
+    }
+  }
+}
+
+}  // namespace tebako
@@ -0,0 +1,105 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-stat-cache.h>
+
+namespace tebako {
+
+inode_stat_cache::~inode_stat_cache()
+{
+  size_t n_chunks = (count + chunk_size - 1) >> chunk_bits;
+  for (size_t i = 0; i < n_chunks; i++) {
+    delete chunks[i].load(std::memory_order_relaxed);
+  }
+}
+
+// inode_stat_cache::reserve
+//  Must not race with get or put, memfs calls it while loading the image
+void inode_stat_cache::reserve(size_t inode_count)
+{
+  if (count == 0 && inode_count != 0) {
+    size_t n_chunks = (inode_count + chunk_size - 1) >> chunk_bits;
+    chunks = std::make_unique<std::atomic<chunk*>[]>(n_chunks);
+    for (size_t i = 0; i < n_chunks; i++) {
+      chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+    count = inode_count;
+  }
+}
+
+// inode_stat_cache::get
+//
+// returns
+//  cached stat structure or nullptr if the slot is not filled yet
+const struct stat* inode_stat_cache::get(uint32_t ino) const noexcept
+{
+  if (ino >= count) {
+    return nullptr;
+  }
+  chunk* c = chunks[ino >> chunk_bits].load(std::memory_order_acquire);
+  uint32_t i = ino & (chunk_size - 1);
+  if (c == nullptr || c->state[i].load(std::memory_order_acquire) != slot_ready) {
+    return nullptr;
+  }
+  return &c->st[i];
+}
+
+// inode_stat_cache::put
+//  Fills the slot unless it is being filled or has been filled by another thread
+void inode_stat_cache::put(uint32_t ino, const struct stat& st) noexcept
+{
+  if (ino >= count) {
+    return;
+  }
+  auto& p_chunk = chunks[ino >> chunk_bits];
+  chunk* c = p_chunk.load(std::memory_order_acquire);
+  if (c == nullptr) {
+    chunk* n = new (std::nothrow) chunk();
+    if (n == nullptr) {
+      return;
+    }
+    if (p_chunk.compare_exchange_strong(c, n, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      c = n;
+    }
+    else {
+      delete n;
+    }
+  }
+  uint32_t i = ino & (chunk_size - 1);
+  uint8_t expected = slot_empty;
+  if (c->state[i].compare_exchange_strong(expected, slot_filling, std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+    c->st[i] = st;
+    c->state[i].store(slot_ready, std::memory_order_release);
+  }
+}
+
+}  // namespace tebako
@@ -0,0 +1,117 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+#include <tebako-common.h>
+
+namespace {
+class BulkReadTests : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL /* cachesize*/, NULL /* workers */, NULL /* mlock */,
+                     NULL /* decompress_ratio*/, NULL /* image_offset */
+    );
+  }
+
+  static void TearDownTestSuite()
+  {
+    unmount_root_memfs();
+  }
+
+  struct read_result {
+    std::string data;
+    int err;
+  };
+
+  using read_results = std::map<std::string, read_result>;
+
+  static void collect(const char* path, const void* data, size_t size, int err, void* ctx)
+  {
+    auto results = static_cast<read_results*>(ctx);
+    EXPECT_EQ(0, results->count(path));
+    (*results)[path] = {err == 0 ? std::string(static_cast<const char*>(data), size) : std::string(), err};
+  }
+
+  static int txt_filter(const char* name, void* ctx)
+  {
+    ++*static_cast<int*>(ctx);
+    return stdfs::path(name).extension() == ".txt";
+  }
+};
+
+TEST_F(BulkReadTests, tebako_read_many)
+{
+  const char* paths[] = {TEBAKIZE_PATH("file.txt"), TEBAKIZE_PATH("directory-with-90-files/file-10.txt"),
+                         TEBAKIZE_PATH("no-file.txt"), TEBAKIZE_PATH("directory-1")};
+  read_results results;
+  int ret = tebako_read_many(paths, 4, collect, &results);
+  EXPECT_EQ(2, ret);
+  EXPECT_EQ(4, results.size());
+
+  EXPECT_EQ(0, results[TEBAKIZE_PATH("file.txt")].err);
+  EXPECT_EQ("Just a file", results[TEBAKIZE_PATH("file.txt")].data.substr(0, 11));
+  EXPECT_EQ(0, results[TEBAKIZE_PATH("directory-with-90-files/file-10.txt")].err);
+  EXPECT_EQ("This is test file number 10",
+            results[TEBAKIZE_PATH("directory-with-90-files/file-10.txt")].data.substr(0, 27));
+  EXPECT_EQ(ENOENT, results[TEBAKIZE_PATH("no-file.txt")].err);
+  EXPECT_EQ(EISDIR, results[TEBAKIZE_PATH("directory-1")].err);
+}
+
+TEST_F(BulkReadTests, tebako_read_many_no_callback)
+{
+  const char* paths[] = {TEBAKIZE_PATH("file.txt")};
+  EXPECT_EQ(-1, tebako_read_many(paths, 1, NULL, NULL));
+  EXPECT_EQ(EFAULT, errno);
+}
+
+TEST_F(BulkReadTests, tebako_read_dir_files)
+{
+  read_results results;
+  int calls = 0;
+  int ret = tebako_read_dir_files(TEBAKIZE_PATH("directory-with-90-files"), txt_filter, &calls, collect, &results);
+  EXPECT_EQ(90, ret);
+  EXPECT_EQ(90, calls);
+  EXPECT_EQ(90, results.size());
+  for (auto& [path, result] : results) {
+    EXPECT_EQ(0, result.err);
+    std::string number = stdfs::path(path).stem().string().substr(5);
+    EXPECT_EQ("This is test file number " + number, result.data.substr(0, 25 + number.size()));
+  }
+}
+
+TEST_F(BulkReadTests, tebako_read_dir_files_no_dir)
+{
+  read_results results;
+  EXPECT_EQ(-1, tebako_read_dir_files(TEBAKIZE_PATH("no-directory"), NULL, NULL, collect, &results));
+  EXPECT_EQ(ENOENT, errno);
+  EXPECT_EQ(0, results.size());
+}
+
+}  // namespace
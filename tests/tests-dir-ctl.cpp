@@ -292,6 +292,33 @@ TEST_F(DirCtlTests, tebako_dir_ctl_root)
   }
 }
 
+TEST_F(DirCtlTests, tebako_dir_ctl_relative_dot_dot)
+{
+  int ret = tebako_chdir(TEBAKIZE_PATH("directory-1"));
+  EXPECT_EQ(0, ret);
+  ret = tebako_chdir("./level-2//../../directory-2/.");
+  EXPECT_EQ(0, ret);
+
+  char* r2 = tebako_getcwd(NULL, 0);
+  EXPECT_STREQ(r2, TEBAKIZE_PATH("directory-2" __S__));
+  if (r2) {
+    free(r2);
+  }
+
+  struct STAT_TYPE st;
+  ret = tebako_stat("file-in-directory-2.txt", &st);
+  EXPECT_EQ(0, ret);
+
+  tebako_small_path t_path;
+  const char* p_path = to_tebako_path(t_path, "a//b/./../c/..");
+  std::string expected = stdfs::path(TEBAKIZE_PATH("directory-2/a/")).lexically_normal().generic_string();
+  EXPECT_STREQ(p_path, expected.c_str());
+
+  p_path = to_tebako_path(t_path, "../../../..");
+  expected = stdfs::path(TEBAKIZE_PATH("")).root_path().generic_string();
+  EXPECT_STREQ(p_path, expected.c_str());
+}
+
 #ifdef _WIN32
 TEST_F(DirCtlTests, is_tebako_path_w)
 {
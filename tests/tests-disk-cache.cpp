@@ -0,0 +1,205 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+struct tebako_dirent;
+
+#include <tebako-io-inner.h>
+
+#ifdef _WIN32
+#undef lseek
+#undef close
+#undef read
+#undef pread
+
+#undef chdir
+#undef mkdir
+#undef rmdir
+#undef unlink
+#undef access
+#undef fstat
+#undef stat
+#undef lstat
+#undef getcwd
+#undef opendir
+#undef readdir
+#undef telldir
+#undef seekdir
+#undef rewinddir
+#undef closedir
+#endif
+
+#include <tebako-memfs.h>
+#include <tebako-memfs.h>
+#include <tebako-disk-cache.h>
+
+namespace tebako {
+
+class DiskCacheTests : public ::testing::Test {
+ protected:
+  stdfs::path root;
+  std::vector<char> image;
+
+  void SetUp() override
+  {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(100000, 999999);
+    root = stdfs::temp_directory_path() / ("tebako-disk-cache-" + std::to_string(dis(gen)));
+
+    image.resize(200000);
+    for (size_t i = 0; i < image.size(); ++i) {
+      image[i] = static_cast<char>(i * 17 + 3);
+    }
+  }
+
+  void TearDown() override
+  {
+    std::error_code ec;
+    stdfs::remove_all(root, ec);
+  }
+};
+
+TEST_F(DiskCacheTests, put_and_get)
+{
+  const std::string content = "Cached file content";
+  {
+    disk_cache cache(root.string(), image.data(), image.size(), disk_cache::default_max_entry_size);
+    bool cacheable = false;
+    EXPECT_EQ(nullptr, cache.get(7, cacheable));
+    EXPECT_TRUE(cacheable);
+
+    auto entry = cache.put(7, content.data(), content.size());
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ(content, std::string(entry->data(), entry->size()));
+  }
+
+  // Next "process run"
+  disk_cache cache(root.string(), image.data(), image.size(), disk_cache::default_max_entry_size);
+  bool cacheable = false;
+  auto entry = cache.get(7, cacheable);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(content, std::string(entry->data(), entry->size()));
+}
+
+TEST_F(DiskCacheTests, image_identity)
+{
+  disk_cache cache(root.string(), image.data(), image.size(), disk_cache::default_max_entry_size);
+  EXPECT_NE(nullptr, cache.put(7, "abc", 3));
+
+  image[image.size() - 1] ^= 1;
+  EXPECT_NE(disk_cache::image_id(image.data(), image.size()), stdfs::path(cache.directory()).filename().string());
+
+  disk_cache other(root.string(), image.data(), image.size(), disk_cache::default_max_entry_size);
+  bool cacheable = false;
+  EXPECT_EQ(nullptr, other.get(7, cacheable));
+}
+
+TEST_F(DiskCacheTests, image_identity_covers_whole_image)
+{
+  std::string id = disk_cache::image_id(image.data(), image.size());
+  image[image.size() / 2] ^= 1;
+  EXPECT_NE(id, disk_cache::image_id(image.data(), image.size()));
+}
+
+TEST_F(DiskCacheTests, mapped_entries_limit)
+{
+  disk_cache cache(root.string(), image.data(), image.size(), disk_cache::default_max_entry_size, 2);
+  for (uint32_t inode = 1; inode <= 5; ++inode) {
+    std::string content = "content " + std::to_string(inode);
+    EXPECT_NE(nullptr, cache.put(inode, content.data(), content.size()));
+  }
+  EXPECT_EQ(2u, cache.mapped_entries());
+
+  // Evicted entries are mapped again
+  for (uint32_t inode = 1; inode <= 5; ++inode) {
+    bool cacheable = false;
+    auto entry = cache.get(inode, cacheable);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ("content " + std::to_string(inode), std::string(entry->data(), entry->size()));
+    EXPECT_LE(cache.mapped_entries(), 2u);
+  }
+}
+
+TEST_F(DiskCacheTests, damaged_entry)
+{
+  {
+    disk_cache cache(root.string(), image.data(), image.size(), disk_cache::default_max_entry_size);
+    EXPECT_NE(nullptr, cache.put(7, "abcdef", 6));
+  }
+
+  auto path = stdfs::path(root) / disk_cache::image_id(image.data(), image.size()) / "7";
+  {
+    std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(-1, std::ios::end);
+    f.put('X');
+  }
+
+  disk_cache cache(root.string(), image.data(), image.size(), disk_cache::default_max_entry_size);
+  bool cacheable = false;
+  EXPECT_EQ(nullptr, cache.get(7, cacheable));
+  EXPECT_TRUE(cacheable);
+}
+
+TEST_F(DiskCacheTests, entry_size_limit)
+{
+  disk_cache cache(root.string(), image.data(), image.size(), 4);
+  EXPECT_EQ(nullptr, cache.put(7, "abcdef", 6));
+  bool cacheable = true;
+  EXPECT_EQ(nullptr, cache.get(7, cacheable));
+  EXPECT_FALSE(cacheable);
+}
+
+TEST_F(DiskCacheTests, mount_with_disk_cache)
+{
+  memfs::set_disk_cache(root.string().c_str());
+  int ret = mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), nullptr /* cachesize*/, nullptr /* workers */,
+                             nullptr /* mlock */, nullptr /* decompress_ratio*/, nullptr /* image_offset */
+  );
+  EXPECT_EQ(0, ret);
+
+  for (int pass = 0; pass < 2; ++pass) {
+    char buf[64] = {0};
+    int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+    EXPECT_LT(0, fh);
+    EXPECT_EQ(11, tebako_read(fh, buf, 11));
+    EXPECT_STREQ("Just a file", buf);
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+
+  unmount_root_memfs();
+  memfs::set_disk_cache(nullptr);
+
+  auto dir = root / disk_cache::image_id(&gfsData[0], gfsSize);
+  EXPECT_TRUE(stdfs::exists(dir));
+  EXPECT_FALSE(stdfs::is_empty(dir));
+}
+
+}  // namespace tebako
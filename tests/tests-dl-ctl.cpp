@@ -257,6 +257,100 @@ TEST_F(DlTests, tebako_dlmap2file_relative_path)
   }
 }
 
+#ifdef TEBAKO_HAS_MEMFD_CREATE
+TEST_F(DlTests, tebako_dlmap2file_memfd)
+{
+  char* dlmapped1 = tebako_dlmap2file(TEBAKIZE_PATH("directory-1/" __LIBEMPTY__));
+  char* dlmapped2 = tebako_dlmap2file(TEBAKIZE_PATH("directory-1/" __LIBEMPTY__));
+  EXPECT_NE(dlmapped1, nullptr);
+  EXPECT_NE(dlmapped2, nullptr);
+  if (dlmapped1 != nullptr && dlmapped2 != nullptr) {
+    // memfd is not available if the kernel forbids executable memfd, the temporary directory is used then
+    EXPECT_STREQ(dlmapped1, dlmapped2);
+    if (strncmp(dlmapped1, "/proc/self/fd/", 14) == 0) {
+      int fd = atoi(dlmapped1 + 14);
+      EXPECT_EQ(-1, ::write(fd, "x", 1));
+    }
+    void* handle = ::dlopen(dlmapped1, RTLD_LAZY | RTLD_GLOBAL);
+    EXPECT_NE(handle, nullptr);
+    if (handle != nullptr) {
+      ::dlclose(handle);
+    }
+  }
+  free(dlmapped1);
+  free(dlmapped2);
+}
+#endif
+
+TEST_F(DlTests, tebako_dlmap2file_concurrent)
+{
+  const int n_threads = 8;
+  std::vector<std::string> mapped(n_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < n_threads; ++i) {
+    threads.emplace_back([&mapped, i]() {
+      char* p = tebako_dlmap2file(TEBAKIZE_PATH("directory-1/" __LIBEMPTY__));
+      if (p != nullptr) {
+        mapped[i] = p;
+        free(p);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  EXPECT_FALSE(mapped[0].empty());
+  for (int i = 1; i < n_threads; ++i) {
+    EXPECT_EQ(mapped[0], mapped[i]);
+  }
+}
+
+TEST_F(DlTests, tebako_dl_prefetch)
+{
+  const char* paths[] = {TEBAKIZE_PATH("directory-1/" __LIBEMPTY__), TEBAKIZE_PATH("no_file"), __AT_BIN__("no_file")};
+  EXPECT_EQ(2, tebako_dl_prefetch(paths, 3));
+
+  void* handle = tebako_dlopen(TEBAKIZE_PATH("directory-1/" __LIBEMPTY__), RTLD_LAZY | RTLD_GLOBAL);
+  EXPECT_NE(handle, nullptr);
+  if (handle != nullptr) {
+    EXPECT_EQ(0, dlclose(handle));
+  }
+
+  EXPECT_EQ(0, tebako_dl_prefetch(paths, 0));
+}
+
+TEST_F(DlTests, tebako_dlopen_cached)
+{
+  auto cache = stdfs::temp_directory_path() / "tebako-dl-cache-test";
+  std::error_code ec;
+  stdfs::remove_all(cache, ec);
+  tebako_set_dl_cache(cache.string().c_str());
+
+  char* dlmapped = tebako_dlmap2file(TEBAKIZE_PATH("directory-1/" __LIBEMPTY__));
+  EXPECT_NE(dlmapped, nullptr);
+  if (dlmapped != nullptr) {
+    EXPECT_EQ(std::string(__LIBEMPTY__), stdfs::path(dlmapped).filename().string());
+    void* handle = ::dlopen(dlmapped, RTLD_LAZY | RTLD_GLOBAL);
+    EXPECT_NE(handle, nullptr);
+    if (handle != nullptr) {
+      ::dlclose(handle);
+    }
+
+    // Exactly one content-addressed entry of the same size
+    int n = 0;
+    for (auto& entry : stdfs::directory_iterator(cache)) {
+      EXPECT_EQ(stdfs::file_size(dlmapped), entry.file_size());
+      ++n;
+    }
+    EXPECT_EQ(1, n);
+    free(dlmapped);
+  }
+
+  tebako_set_dl_cache(NULL);
+  stdfs::remove_all(cache, ec);
+}
+
 TEST_F(DlTests, tebako_dlmap2file_pass_through)
 {
   char* dlmapped;
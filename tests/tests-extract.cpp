@@ -0,0 +1,156 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+#include <tebako-common.h>
+#include <tebako-cmdline.h>
+
+namespace {
+class ExtractTests : public testing::Test {
+ protected:
+  stdfs::path tmp_name;
+
+  static void SetUpTestSuite()
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL /* cachesize*/, NULL /* workers */, NULL /* mlock */,
+                     NULL /* decompress_ratio*/, NULL /* image_offset */
+    );
+  }
+
+  static void TearDownTestSuite()
+  {
+    unmount_root_memfs();
+  }
+
+  void SetUp() override
+  {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(100000, 999999);
+    tmp_name = stdfs::temp_directory_path() / ("tebako-extract-" + std::to_string(dis(gen)));
+  }
+
+  void TearDown() override
+  {
+    std::error_code ec;
+    stdfs::remove_all(tmp_name, ec);
+  }
+
+  static std::string read_host_file(const stdfs::path& p)
+  {
+    std::ifstream in(p, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  static std::string read_memfs_file(const std::string& p)
+  {
+    std::string ret;
+    int fh = tebako_open(2, p.c_str(), O_RDONLY);
+    EXPECT_LT(0, fh);
+    if (fh > 0) {
+      char buf[256];
+      ssize_t n;
+      while ((n = tebako_read(fh, buf, sizeof(buf))) > 0) {
+        ret.append(buf, n);
+      }
+      tebako_close(fh);
+    }
+    return ret;
+  }
+};
+
+TEST_F(ExtractTests, tebako_extract_directory)
+{
+  int ret = tebako_extract(TEBAKIZE_PATH("directory-with-90-files"), tmp_name.string().c_str(), 0);
+  EXPECT_EQ(0, ret);
+
+  int n = 0;
+  for (auto& entry : stdfs::directory_iterator(tmp_name)) {
+    EXPECT_TRUE(entry.is_regular_file());
+    std::string name = entry.path().filename().string();
+    EXPECT_EQ(read_memfs_file(std::string(TEBAKIZE_PATH("directory-with-90-files/")) + name),
+              read_host_file(entry.path()));
+    ++n;
+  }
+  EXPECT_EQ(90, n);
+}
+
+TEST_F(ExtractTests, tebako_extract_skip_unchanged)
+{
+  int ret = tebako_extract(TEBAKIZE_PATH("directory-with-90-files"), tmp_name.string().c_str(), 0);
+  EXPECT_EQ(0, ret);
+
+  auto p = tmp_name / "file-10.txt";
+  auto t = stdfs::last_write_time(p);
+  ret = tebako_extract(TEBAKIZE_PATH("directory-with-90-files"), tmp_name.string().c_str(),
+                       TEBAKO_EXTRACT_SKIP_UNCHANGED);
+  EXPECT_EQ(0, ret);
+  EXPECT_EQ(t, stdfs::last_write_time(p));
+  EXPECT_EQ("This is test file number 10", read_host_file(p).substr(0, 27));
+}
+
+TEST_F(ExtractTests, tebako_extract_file)
+{
+  int ret = tebako_extract(TEBAKIZE_PATH("file.txt"), tmp_name.string().c_str(), 0);
+  EXPECT_EQ(0, ret);
+  EXPECT_EQ(read_memfs_file(TEBAKIZE_PATH("file.txt")), read_host_file(tmp_name));
+}
+
+TEST_F(ExtractTests, tebako_extract_no_file)
+{
+  int ret = tebako_extract(TEBAKIZE_PATH("no-file.txt"), tmp_name.string().c_str(), 0);
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(ENOENT, errno);
+}
+
+TEST_F(ExtractTests, cmdline_extract_is_native)
+{
+  std::string dest = tmp_name.string();
+  const int argc = 3;
+  const char* argv[argc] = {"program", "--tebako-extract", dest.c_str()};
+
+  tebako::cmdline_args args(argc, argv);
+  args.parse_arguments();
+  args.build_arguments(TEBAKIZE_PATH("directory-with-90-files"), "/local/test.rb");
+
+  // Files are extracted before Ruby starts, Ruby gets an empty script
+  EXPECT_EQ(3, args.get_argc());
+  EXPECT_STREQ("-e", args.get_argv()[1]);
+  EXPECT_STREQ("", args.get_argv()[2]);
+  EXPECT_EQ("This is test file number 10", read_host_file(tmp_name / "file-10.txt").substr(0, 27));
+}
+
+TEST_F(ExtractTests, tebako_extract_outside_memfs)
+{
+  int ret = tebako_extract(stdfs::temp_directory_path().string().c_str(), tmp_name.string().c_str(), 0);
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace
@@ -0,0 +1,104 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+#include <tebako-common.h>
+
+namespace {
+class FeatureTests : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL /* cachesize*/, NULL /* workers */, NULL /* mlock */,
+                     NULL /* decompress_ratio*/, NULL /* image_offset */
+    );
+  }
+
+  static void TearDownTestSuite()
+  {
+    unmount_root_memfs();
+  }
+};
+
+TEST_F(FeatureTests, tebako_resolve_feature)
+{
+  const char* load_path[] = {TEBAKIZE_PATH("no-directory"), TEBAKIZE_PATH("directory-1"), TEBAKIZE_PATH("directory-2")};
+  const char* exts[] = {".rb", ".txt", NULL};
+  char out[TEBAKO_PATH_LENGTH + 1];
+
+  int ret = tebako_resolve_feature("file-in-directory-2", load_path, 3, exts, out, sizeof(out));
+  EXPECT_EQ(0, ret);
+  EXPECT_EQ(stdfs::path(TEBAKIZE_PATH("directory-2/file-in-directory-2.txt")).generic_string(), std::string(out));
+
+  // The first load path entry wins
+  const char* load_path_2[] = {TEBAKIZE_PATH("directory-1"), TEBAKIZE_PATH("")};
+  ret = tebako_resolve_feature("level-2", load_path_2, 2, NULL, out, sizeof(out));
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(ENOENT, errno);
+  ret = tebako_resolve_feature("file", load_path_2, 2, exts, out, sizeof(out));
+  EXPECT_EQ(0, ret);
+  EXPECT_EQ(stdfs::path(TEBAKIZE_PATH("file.txt")).generic_string(), std::string(out));
+
+  ret = tebako_resolve_feature("file-in-directory-2.txt", load_path, 3, NULL, out, 8);
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(ERANGE, errno);
+}
+
+TEST_F(FeatureTests, tebako_resolve_feature_miss)
+{
+  const char* load_path[] = {TEBAKIZE_PATH("directory-1"), TEBAKIZE_PATH("directory-2")};
+  const char* exts[] = {".rb", ".so", NULL};
+  char out[TEBAKO_PATH_LENGTH + 1];
+
+  // The second call is answered from the negative cache
+  for (int i = 0; i < 2; i++) {
+    errno = 0;
+    int ret = tebako_resolve_feature("no-feature", load_path, 2, exts, out, sizeof(out));
+    EXPECT_EQ(-1, ret);
+    EXPECT_EQ(ENOENT, errno);
+  }
+
+  // A different extension list is a different fingerprint
+  const char* exts_2[] = {".txt", NULL};
+  int ret = tebako_resolve_feature("file-in-directory-1", load_path, 2, exts_2, out, sizeof(out));
+  EXPECT_EQ(0, ret);
+  EXPECT_EQ(stdfs::path(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt")).generic_string(), std::string(out));
+}
+
+TEST_F(FeatureTests, tebako_resolve_feature_absolute)
+{
+  const char* exts[] = {".rb", ".txt", NULL};
+  char out[TEBAKO_PATH_LENGTH + 1];
+
+  int ret = tebako_resolve_feature(TEBAKIZE_PATH("file"), NULL, 0, exts, out, sizeof(out));
+  EXPECT_EQ(0, ret);
+  EXPECT_STREQ(TEBAKIZE_PATH("file.txt"), out);
+}
+
+}  // namespace
@@ -225,6 +225,36 @@ TEST_F(FileCtlTests, tebako_stat_absolute_path_no_file)
   EXPECT_EQ(-1, ret);
 }
 
+TEST_F(FileCtlTests, tebako_stat_absolute_path_not_dir)
+{
+  struct STAT_TYPE st;
+  int ret = tebako_stat(TEBAKIZE_PATH("file.txt/no_file.txt"), &st);
+  EXPECT_EQ(ENOTDIR, errno);
+  EXPECT_EQ(-1, ret);
+
+  ret = tebako_stat(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt/level-2/no_file.txt"), &st);
+  EXPECT_EQ(ENOTDIR, errno);
+  EXPECT_EQ(-1, ret);
+}
+
+//  Run with --gtest_also_run_disabled_tests to measure the cost of failed lookups
+TEST_F(FileCtlTests, DISABLED_tebako_stat_miss_benchmark)
+{
+  const char* paths[] = {TEBAKIZE_PATH("no_file.txt"), TEBAKIZE_PATH("directory-1/level-2/no_dir/no_file.txt"),
+                         TEBAKIZE_PATH("file.txt/no_file.txt")};
+  const int iterations = 1000000;
+  struct STAT_TYPE st;
+  for (const char* path : paths) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      EXPECT_EQ(-1, tebako_stat(path, &st));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << path << ": " << std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations << " ns"
+              << std::endl;
+  }
+}
+
 TEST_F(FileCtlTests, tebako_stat_null)
 {
   struct STAT_TYPE st;
@@ -609,4 +609,45 @@ TEST_F(FileIOTests, tebako_readv_invalid_fd)
   EXPECT_EQ(errno, EBADF);
 }
 #endif
+
+TEST_F(FileIOTests, tebako_open_by_handle)
+{
+  struct tebako_file_handle handle;
+  int ret = tebako_name_to_handle(TEBAKIZE_PATH("file.txt"), &handle);
+  EXPECT_EQ(0, ret);
+
+  for (int i = 0; i < 2; i++) {
+    int fh = tebako_open_by_handle(&handle, O_RDONLY);
+    EXPECT_LT(0, fh);
+    char readbuf[11];
+    ret = tebako_read(fh, readbuf, sizeof(readbuf));
+    EXPECT_EQ(sizeof(readbuf), ret);
+    EXPECT_EQ(0, strncmp(readbuf, "Just a file", sizeof(readbuf)));
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+
+  EXPECT_EQ(-1, tebako_open_by_handle(&handle, O_RDWR));
+  EXPECT_EQ(EROFS, errno);
+#ifdef O_DIRECTORY
+  EXPECT_EQ(-1, tebako_open_by_handle(&handle, O_RDONLY | O_DIRECTORY));
+  EXPECT_EQ(ENOTDIR, errno);
+#endif
+
+  struct tebako_file_handle stale = handle;
+  stale.generation++;
+  EXPECT_EQ(-1, tebako_open_by_handle(&stale, O_RDONLY));
+  EXPECT_EQ(ESTALE, errno);
+}
+
+TEST_F(FileIOTests, tebako_name_to_handle_errors)
+{
+  struct tebako_file_handle handle;
+  EXPECT_EQ(-1, tebako_name_to_handle(TEBAKIZE_PATH("no_file.txt"), &handle));
+  EXPECT_EQ(ENOENT, errno);
+  EXPECT_EQ(-1, tebako_name_to_handle(__AT_BIN__(__SHELL__), &handle));
+  EXPECT_EQ(EOPNOTSUPP, errno);
+  EXPECT_EQ(-1, tebako_name_to_handle(NULL, &handle));
+  EXPECT_EQ(EFAULT, errno);
+}
+
 }  // namespace
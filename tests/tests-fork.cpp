@@ -0,0 +1,91 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+#include <tebako-common.h>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+
+namespace {
+class ForkTests : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL /* cachesize*/, NULL /* workers */, NULL /* mlock */,
+                     NULL /* decompress_ratio*/, NULL /* image_offset */
+    );
+  }
+
+  static void TearDownTestSuite()
+  {
+    unmount_root_memfs();
+  }
+
+  static bool read_file_txt(void)
+  {
+    char buf[64] = {0};
+    int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+    if (fh < 0) {
+      return false;
+    }
+    ssize_t n = tebako_read(fh, buf, 11);
+    tebako_close(fh);
+    return n == 11 && strcmp(buf, "Just a file") == 0;
+  }
+};
+
+TEST_F(ForkTests, tebako_prefork_warmup)
+{
+  const char* paths[] = {TEBAKIZE_PATH("directory-with-90-files"), TEBAKIZE_PATH("file.txt"),
+                         TEBAKIZE_PATH("no-file.txt")};
+  EXPECT_EQ(91, tebako_prefork_warmup(paths, 3));
+}
+
+TEST_F(ForkTests, read_in_child_process)
+{
+  EXPECT_TRUE(read_file_txt());
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Exit without running destructors and atexit handlers of the test process
+    _exit(read_file_txt() ? 0 : 1);
+  }
+  ASSERT_LT(0, pid);
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+
+  // The parent is not affected
+  EXPECT_TRUE(read_file_txt());
+}
+
+}  // namespace
+#endif
@@ -121,6 +121,16 @@ TEST_F(LoadTests2, tebako_load_valid_filesystem)
   EXPECT_LE(1, ret);
 }
 
+TEST_F(LoadTests2, tebako_load_twice_at_the_same_point)
+{
+  int ret = mount_memfs(buffer.data(), size, "auto", 0, "dummy");
+  EXPECT_LE(1, ret);
+  errno = 0;
+  EXPECT_EQ(-1, mount_memfs(buffer.data(), size, "auto", 0, "dummy"));
+  EXPECT_EQ(EEXIST, errno);
+  EXPECT_FALSE(tebako::sync_tebako_memfs_table::get_tebako_memfs_table().check(ret + 1));
+}
+
 TEST_F(LoadTests2, tebako_load_invalid_filesystem)
 {
   const unsigned char data[] = "This is broken filesystem image";
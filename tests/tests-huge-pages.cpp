@@ -0,0 +1,145 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+struct tebako_dirent;
+
+#include <tebako-io-inner.h>
+
+#ifdef _WIN32
+#undef lseek
+#undef close
+#undef read
+#undef pread
+
+#undef chdir
+#undef mkdir
+#undef rmdir
+#undef unlink
+#undef access
+#undef fstat
+#undef stat
+#undef lstat
+#undef getcwd
+#undef opendir
+#undef readdir
+#undef telldir
+#undef seekdir
+#undef rewinddir
+#undef closedir
+#endif
+
+#include <tebako-memfs.h>
+#include <tebako-huge-pages.h>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace tebako {
+
+TEST(HugePagesTests, image_in_place)
+{
+  std::vector<char> src(3 * huge_page_image::huge_page_size + 12345);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<char>(i * 31 + 7);
+  }
+  std::vector<char> copy(src);
+
+  huge_page_image image(src.data(), src.size());
+  EXPECT_EQ(image.size(), src.size());
+  EXPECT_EQ(image.data(), static_cast<const void*>(src.data()));  // The image is not copied
+  EXPECT_EQ(0, memcmp(image.data(), copy.data(), copy.size()));
+
+  if (image.is_huge()) {
+    EXPECT_EQ(0, image.huge_size() % huge_page_image::huge_page_size);
+    EXPECT_LE(image.huge_size(), src.size());
+    EXPECT_GE(image.huge_size(), huge_page_image::huge_page_size);
+  }
+  else {
+    EXPECT_EQ(0, image.huge_size());
+  }
+
+  huge_page_image small(src.data(), huge_page_image::huge_page_size / 2);
+  EXPECT_FALSE(small.is_huge());
+}
+
+TEST(HugePagesTests, mount_with_huge_pages)
+{
+  memfs::set_huge_pages("true");
+  int ret = mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), nullptr /* cachesize*/, nullptr /* workers */,
+                             nullptr /* mlock */, nullptr /* decompress_ratio*/, nullptr /* image_offset */
+  );
+  EXPECT_EQ(0, ret);
+
+  struct STAT_TYPE st;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("file.txt"), &st));
+
+  unmount_root_memfs();
+  memfs::set_huge_pages(nullptr);
+}
+
+#if !defined(_WIN32)
+// Minor page faults and time of reading every file of the image, with and without huge pages
+// dTLB misses are measured externally, e.g.
+//  perf stat -e dTLB-load-misses,page-faults tests --gtest_also_run_disabled_tests --gtest_filter=*page_fault_benchmark
+TEST(HugePagesTests, DISABLED_page_fault_benchmark)
+{
+  for (const char* huge_pages : {"false", "true"}) {
+    memfs::set_huge_pages(huge_pages);
+    // A private copy, so that the embedded image pages faulted by earlier tests are not reused
+    std::vector<char> image(&gfsData[0], &gfsData[0] + gfsSize);
+    ASSERT_EQ(0, mount_root_memfs(image.data(), gfsSize, tests_log_level(), nullptr /* cachesize*/,
+                                  nullptr /* workers */, nullptr /* mlock */, nullptr /* decompress_ratio*/,
+                                  nullptr /* image_offset */
+                                  ));
+
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    auto t0 = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+    for (int i = 0; i < 100; i++) {
+      tebako_read_dir_files(
+          TEBAKIZE_PATH("directory-with-90-files"), nullptr, nullptr,
+          [](const char*, const void*, size_t size, int, void* ctx) { *static_cast<size_t*>(ctx) += size; }, &bytes);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    getrusage(RUSAGE_SELF, &after);
+    std::cout << "huge pages " << huge_pages << ": " << (after.ru_minflt - before.ru_minflt) << " minor faults, "
+              << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms (" << bytes << " bytes)"
+              << std::endl;
+
+    unmount_root_memfs();
+  }
+  memfs::set_huge_pages(nullptr);
+}
+#endif
+
+}  // namespace tebako
@@ -477,5 +477,68 @@ TEST_F(LnTests, tebako_openat_link_nofollow_relative)
 }
 #endif
 
+TEST_F(LnTests, tebako_realpath)
+{
+  char resolved[PATH_MAX];
+  char* r = tebako_realpath(TEBAKIZE_PATH("s-link-to-file-1"), resolved);
+  EXPECT_EQ(resolved, r);
+  EXPECT_STREQ(stdfs::path(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt")).generic_string().c_str(), r);
+
+  r = tebako_realpath(TEBAKIZE_PATH("directory-1/s-link-to-level-2"), resolved);
+  EXPECT_STREQ(stdfs::path(TEBAKIZE_PATH("directory-1/level-2/file-at-level-2.txt")).generic_string().c_str(), r);
+
+  r = tebako_realpath(TEBAKIZE_PATH("s-link-to-dir-1/./file-in-directory-2.txt"), NULL);
+  ASSERT_NE(nullptr, r);
+  EXPECT_STREQ(stdfs::path(TEBAKIZE_PATH("directory-2/file-in-directory-2.txt")).generic_string().c_str(), r);
+  free(r);
+
+  //  The second call is answered from the cache
+  EXPECT_EQ(0, tebako_chdir(TEBAKIZE_PATH("directory-1")));
+  r = tebako_realpath("../s-link-to-dir-1/", resolved);
+  EXPECT_STREQ(stdfs::path(TEBAKIZE_PATH("directory-2")).generic_string().c_str(), r);
+  r = tebako_realpath("../s-link-to-dir-1/", resolved);
+  EXPECT_STREQ(stdfs::path(TEBAKIZE_PATH("directory-2")).generic_string().c_str(), r);
+
+  r = tebako_realpath(TEBAKIZE_PATH("s-link-to-dir-1/no_file.txt"), resolved);
+  EXPECT_EQ(nullptr, r);
+  EXPECT_EQ(ENOENT, errno);
+
+  r = tebako_realpath(TEBAKIZE_PATH("file.txt/no_file.txt"), resolved);
+  EXPECT_EQ(nullptr, r);
+  EXPECT_EQ(ENOTDIR, errno);
+
+  r = tebako_realpath(TEBAKIZE_PATH("s-link-outside-of-memfs"), resolved);
+  ASSERT_NE(nullptr, r);
+  EXPECT_FALSE(within_tebako_memfs(r));
+}
+
+TEST_F(LnTests, tebako_stat_absolute_link)
+{
+  struct STAT_TYPE st;
+  int ret = tebako_stat(TEBAKIZE_PATH("a-link-to-dir-2/file-in-directory-2.txt"), &st);
+  EXPECT_EQ(0, ret);
+  EXPECT_TRUE(S_ISREG(st.st_mode));
+
+  ret = tebako_stat(TEBAKIZE_PATH("a-link-to-dir-2"), &st);
+  EXPECT_EQ(0, ret);
+  EXPECT_TRUE(S_ISDIR(st.st_mode));
+
+  ret = tebako_lstat(TEBAKIZE_PATH("a-link-to-dir-2"), &st);
+  EXPECT_EQ(0, ret);
+  EXPECT_TRUE(S_ISLNK(st.st_mode));
+}
+
+TEST_F(LnTests, tebako_stat_absolute_link_loop)
+{
+  struct STAT_TYPE st;
+  int ret = tebako_stat(TEBAKIZE_PATH("a-link-to-loop-1"), &st);
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(ELOOP, errno);
+
+  char resolved[PATH_MAX];
+  EXPECT_EQ(nullptr, tebako_realpath(TEBAKIZE_PATH("a-link-to-loop-2"), resolved));
+  EXPECT_EQ(ELOOP, errno);
+}
+
 #endif
 }  // namespace
@@ -0,0 +1,168 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+struct tebako_dirent;
+
+#include <tebako-io-inner.h>
+
+#ifdef _WIN32
+#undef lseek
+#undef close
+#undef read
+#undef pread
+
+#undef chdir
+#undef mkdir
+#undef rmdir
+#undef unlink
+#undef access
+#undef fstat
+#undef stat
+#undef lstat
+#undef getcwd
+#undef opendir
+#undef readdir
+#undef telldir
+#undef seekdir
+#undef rewinddir
+#undef closedir
+#endif
+
+#include <tebako-io-root.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+#include <tebako-memfs-overlay.h>
+#include <tebako-mount-table.h>
+
+namespace tebako {
+
+class MemfsOverlayTests : public ::testing::Test {
+ protected:
+  std::vector<std::shared_ptr<memfs>> layers;
+
+  void SetUp() override
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), nullptr, nullptr, nullptr, nullptr, nullptr);
+
+    std::string filename = tests_the_other_memfs_image();
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    ASSERT_TRUE(file) << "Failed to open file: " << filename;
+
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<char> buffer(size);
+    ASSERT_TRUE(file.read(buffer.data(), size)) << "Failed to read file: " << filename;
+
+    // Bottom layer is the same image as root memfs, top layer is the other one
+    layers.push_back(std::make_shared<memfs>(&gfsData[0], gfsSize));
+    layers.push_back(std::make_shared<memfs>(std::move(buffer)));
+    for (auto& layer : layers) {
+      ASSERT_EQ(0, layer->load("auto"));
+    }
+  }
+
+  void TearDown() override { unmount_root_memfs(); }
+};
+
+TEST_F(MemfsOverlayTests, resolve)
+{
+  auto root = sync_tebako_memfs_table::get_tebako_memfs_table().get(0)->get_root_inode();
+  ASSERT_GT(mount_memfs_overlay(layers, root, "m-overlay"), 0);
+
+  auto mount_point = sync_tebako_mount_table::get_tebako_mount_table().get(root, "m-overlay");
+  ASSERT_TRUE(mount_point.has_value());
+  ASSERT_TRUE(std::holds_alternative<std::shared_ptr<memfs_overlay>>(*mount_point));
+
+  auto overlay = std::get<std::shared_ptr<memfs_overlay>>(*mount_point);
+  uint32_t bottom = overlay->get_layers().front();
+  uint32_t top = overlay->get_layers().back();
+
+  EXPECT_EQ(overlay->resolve(""), top);
+  EXPECT_EQ(overlay->resolve("fs2-file.txt"), top);
+  EXPECT_EQ(overlay->resolve("fs2-directory-1/fs2-file-in-directory-1.txt"), top);
+  EXPECT_EQ(overlay->resolve("file.txt"), bottom);
+  EXPECT_EQ(overlay->resolve("directory-1/file-in-directory-1.txt"), bottom);
+  EXPECT_EQ(overlay->resolve("no-such-directory/no-such-file.txt"), top);
+
+  // Hidden by the whiteout of the top layer
+  EXPECT_EQ(overlay->resolve("file2.txt"), top);
+
+  // Subtrees that come from a single layer are not indexed entry by entry
+  EXPECT_LT(overlay->index_size(), 90u);
+}
+
+TEST_F(MemfsOverlayTests, stat_through_overlay)
+{
+  EXPECT_GT(mount_memfs_overlay(layers, sync_tebako_memfs_table::get_tebako_memfs_table().get(0)->get_root_inode(),
+                                "m-overlay"),
+            0);
+
+  struct STAT_TYPE st;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("m-overlay/file.txt"), &st));
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("m-overlay/directory-1/file-in-directory-1.txt"), &st));
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("m-overlay/fs2-directory-1/fs2-file-in-directory-1.txt"), &st));
+  EXPECT_EQ(-1, tebako_stat(TEBAKIZE_PATH("m-overlay/no-such-file.txt"), &st));
+  EXPECT_EQ(-1, tebako_stat(TEBAKIZE_PATH("m-overlay/file2.txt"), &st));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+TEST_F(MemfsOverlayTests, readdir_merges_layers)
+{
+  EXPECT_GT(mount_memfs_overlay(layers, sync_tebako_memfs_table::get_tebako_memfs_table().get(0)->get_root_inode(),
+                                "m-overlay"),
+            0);
+
+  DIR* dirp = tebako_opendir(TEBAKIZE_PATH("m-overlay"));
+  ASSERT_TRUE(dirp != NULL);
+
+  std::set<std::string> names;
+#ifdef _WIN32
+  struct direct* entry;
+  while ((entry = tebako_readdir(dirp, NULL)) != NULL) {
+#else
+  struct dirent* entry;
+  while ((entry = tebako_readdir(dirp)) != NULL) {
+#endif
+    EXPECT_TRUE(names.insert(entry->d_name).second) << entry->d_name;
+  }
+  EXPECT_EQ(0, tebako_closedir(dirp));
+
+  EXPECT_EQ(1u, names.count("."));
+  EXPECT_EQ(1u, names.count(".."));
+  EXPECT_EQ(1u, names.count("fs2-file.txt"));        // top layer
+  EXPECT_EQ(1u, names.count("fs2-directory-1"));     // top layer
+  EXPECT_EQ(1u, names.count("file.txt"));            // bottom layer
+  EXPECT_EQ(1u, names.count("directory-1"));         // bottom layer
+  EXPECT_EQ(0u, names.count("file2.txt"));           // hidden by whiteout
+  EXPECT_EQ(0u, names.count(".wh.file2.txt"));       // whiteouts are not listed
+}
+
+}  // namespace tebako
@@ -124,13 +124,27 @@ TEST_F(MemfsTableTests, test_insert_auto)
   EXPECT_EQ(memfs_table.insert_auto(fs02), 2);  // Should insert at 2
   EXPECT_EQ(memfs_table.insert_auto(fs03), 3);  // Should insert at 3
 
-  // Fill up the remaining slots
-  memfs_table.insert_auto(std::make_shared<memfs>("Test04", 6));  // 4
-  memfs_table.insert_auto(std::make_shared<memfs>("Test05", 6));  // 5
-  memfs_table.insert_auto(std::make_shared<memfs>("Test06", 6));  // 6
-  memfs_table.insert_auto(std::make_shared<memfs>("Test07", 6));  // 7
+  EXPECT_EQ(memfs_table.get(3)->get_root_inode(), sync_tebako_memfs_table::fsInoFromFsAndIno(3, 0));
+}
+
+TEST_F(MemfsTableTests, test_insert_auto_many)
+{
+  auto& memfs_table = tebako::sync_tebako_memfs_table::get_tebako_memfs_table();
+  memfs_table.clear();  // Ensure the table is empty
 
-  EXPECT_EQ(memfs_table.insert_auto(std::make_shared<memfs>("Test08", 6)), 0);  // No more valid indices
+  // Hundreds of images if ino_t allows, all available slots otherwise
+  const uint32_t count = std::min(sync_tebako_memfs_table::fsMask, static_cast<uint32_t>(300));
+  for (uint32_t i = 1; i <= count; ++i) {
+    EXPECT_EQ(memfs_table.insert_auto(std::make_shared<memfs>("Test", 4)), i);
+  }
+
+  // Root inodes of different images shall not collide
+  EXPECT_NE(memfs_table.get(1)->get_root_inode(), memfs_table.get(count)->get_root_inode());
+  EXPECT_EQ(sync_tebako_memfs_table::getFsIndex(memfs_table.get(count)->get_root_inode()), count);
+
+  if (count == sync_tebako_memfs_table::fsMask) {
+    EXPECT_EQ(memfs_table.insert_auto(std::make_shared<memfs>("Test", 4)), 0);  // No more valid indices
+  }
 }
 
 TEST_F(MemfsTableTests, test_concurrent_access)
@@ -148,11 +162,85 @@ TEST_F(MemfsTableTests, test_concurrent_access)
   EXPECT_TRUE(memfs_table.check(2));
 }
 
+TEST_F(MemfsTableTests, test_reader_keeps_memfs)
+{
+  auto fs = std::make_shared<memfs>("Test6", 5);
+  std::weak_ptr<memfs> weak = fs;
+  memfs_table.insert(1, std::move(fs));
+
+  std::atomic<bool> erased{false};
+  std::thread reader([&]() {
+    memfs_table_reader r;
+    memfs* p = memfs_table.peek(1);
+    EXPECT_NE(nullptr, p);
+    // erase waits for this reader, so the memfs stays valid while it is used
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(erased.load());
+    EXPECT_FALSE(weak.expired());
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  memfs_table.erase(1);
+  erased = true;
+  reader.join();
+
+  EXPECT_TRUE(weak.expired());
+  EXPECT_EQ(nullptr, memfs_table.peek(1));
+}
+
+TEST_F(MemfsTableTests, test_concurrent_readers_and_writers)
+{
+  EXPECT_EQ(1, memfs_table.insert_auto(std::make_shared<memfs>("Test7", 5)));
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&]() {
+      while (!stop.load()) {
+        memfs_table_reader r;
+        memfs* p = memfs_table.peek(1);
+        EXPECT_NE(nullptr, p);
+        if (p != nullptr) {
+          EXPECT_EQ(sync_tebako_memfs_table::fsInoFromFsAndIno(1, 0), p->get_root_inode());
+        }
+        memfs_table.peek(2);
+      }
+    });
+  }
+  for (int i = 0; i < 200; i++) {
+    EXPECT_EQ(2, memfs_table.insert_auto(std::make_shared<memfs>("Test8", 5)));
+    memfs_table.erase(2);
+  }
+  stop = true;
+  for (auto& t : readers) {
+    t.join();
+  }
+}
+
 TEST_F(MemfsTableTests, fs_ino_and_index)
 {
-  _ino_t t = sync_tebako_memfs_table::fsInoFromFsAndIno(0x1, 0x234);
+  tebako_ino_t t = sync_tebako_memfs_table::fsInoFromFsAndIno(0x1, 0x234);
   EXPECT_EQ(sync_tebako_memfs_table::getFsIndex(t), 0x1);
   EXPECT_EQ(sync_tebako_memfs_table::getFsIno(t), 0x234);
 }
 
+TEST_F(MemfsTableTests, fs_ino_and_index_max)
+{
+  const uint32_t index = sync_tebako_memfs_table::fsMask;
+  const tebako_ino_t ino = sync_tebako_memfs_table::inoMask;
+  tebako_ino_t t = sync_tebako_memfs_table::fsInoFromFsAndIno(index, ino);
+  EXPECT_EQ(sync_tebako_memfs_table::getFsIndex(t), index);
+  EXPECT_EQ(sync_tebako_memfs_table::getFsIno(t), ino);
+  EXPECT_EQ(static_cast<tebako_ino_t>(static_cast<_ino_t>(t)), t);  // Fits into st_ino
+}
+
+TEST_F(MemfsTableTests, inode_count_limit)
+{
+  const uint64_t max_count = static_cast<uint64_t>(sync_tebako_memfs_table::inoMask) + 1;
+  EXPECT_TRUE(sync_tebako_memfs_table::fitsInodeCount(0));
+  EXPECT_TRUE(sync_tebako_memfs_table::fitsInodeCount(max_count));
+  EXPECT_FALSE(sync_tebako_memfs_table::fitsInodeCount(max_count + 1));
+  if (sync_tebako_memfs_table::inoBits == 16) {
+    EXPECT_EQ(8192, max_count);
+  }
+}
+
 }  // namespace tebako
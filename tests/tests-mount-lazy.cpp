@@ -0,0 +1,116 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+struct tebako_dirent;
+
+#include <tebako-io-inner.h>
+
+#ifdef _WIN32
+#undef lseek
+#undef close
+#undef read
+#undef pread
+
+#undef chdir
+#undef mkdir
+#undef rmdir
+#undef unlink
+#undef access
+#undef fstat
+#undef stat
+#undef lstat
+#undef getcwd
+#undef opendir
+#undef readdir
+#undef telldir
+#undef seekdir
+#undef rewinddir
+#undef closedir
+#endif
+
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+
+namespace tebako {
+
+class LazyMountTests : public ::testing::Test {
+ protected:
+  std::vector<char> buffer;
+
+  void SetUp() override
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), nullptr, nullptr, nullptr, nullptr, nullptr);
+    memfs::set_lazy_mount("true");
+
+    std::string filename = tests_the_other_memfs_image();
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    ASSERT_TRUE(file) << "Failed to open file: " << filename;
+
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    buffer.resize(size);
+    ASSERT_TRUE(file.read(buffer.data(), size)) << "Failed to read file: " << filename;
+  }
+
+  void TearDown() override
+  {
+    memfs::set_lazy_mount(nullptr);
+    unmount_root_memfs();
+  }
+};
+
+TEST_F(LazyMountTests, load_on_first_access)
+{
+  int index = mount_memfs_at_root(buffer.data(), buffer.size(), "auto", "m-dir-lazy");
+  ASSERT_GT(index, 0);
+
+  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(index);
+  ASSERT_NE(fs, nullptr);
+  EXPECT_FALSE(fs->is_loaded());
+
+  struct STAT_TYPE st;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("m-dir-lazy/fs2-file.txt"), &st));
+  EXPECT_TRUE(fs->is_loaded());
+}
+
+TEST_F(LazyMountTests, broken_image_fails_on_access)
+{
+  const char data[] = "This is broken filesystem image";
+  int index = mount_memfs_at_root(data, sizeof(data), "auto", "m-dir-lazy-broken");
+  ASSERT_GT(index, 0);
+
+  struct STAT_TYPE st;
+  EXPECT_EQ(-1, tebako_stat(TEBAKIZE_PATH("m-dir-lazy-broken/fs2-file.txt"), &st));
+  EXPECT_EQ(ENOMEM, errno);
+  EXPECT_FALSE(sync_tebako_memfs_table::get_tebako_memfs_table().get(index)->is_loaded());
+}
+
+}  // namespace tebako
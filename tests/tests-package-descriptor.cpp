@@ -420,4 +420,25 @@ TEST(PackageDescriptorTest, construct_from_buffer_wrong_signature)
   EXPECT_THROW(package_descriptor pd(buffer), std::invalid_argument);
 }
 
+TEST(PackageDescriptorTest, serialize_deserialize_dl_prefetch)
+{
+  std::vector<std::string> dl_prefetch = {"/__tebako_memfs__/lib/a.so", "/__tebako_memfs__/lib/b.so"};
+  package_descriptor pd("3.1.2", "2.5.1", "/app", "start.rb", std::nullopt, dl_prefetch);
+
+  std::vector<char> buffer = pd.serialize();
+  package_descriptor pd2(buffer);
+  EXPECT_EQ(pd2.get_entry_point(), "start.rb");
+  EXPECT_EQ(pd2.get_cwd(), std::nullopt);
+  EXPECT_EQ(pd2.get_dl_prefetch(), dl_prefetch);
+
+  // The descriptor is followed by filesystem image
+  std::vector<char> package = package_descriptor("3.1.2", "2.5.1", "/app", "start.rb", std::nullopt).serialize();
+  package.insert(package.end(), {'D', 'W', 'A', 'R', 'F', 'S'});
+  EXPECT_TRUE(package_descriptor(package).get_dl_prefetch().empty());
+
+  // Truncated list
+  buffer.pop_back();
+  EXPECT_THROW(package_descriptor pd3(buffer), std::out_of_range);
+}
+
 }  // namespace tebako
\ No newline at end of file
@@ -0,0 +1,162 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+#include <tebako-common.h>
+
+namespace {
+class PathNormalizeTests : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL /* cachesize*/, NULL /* workers */, NULL /* mlock */,
+                     NULL /* decompress_ratio*/, NULL /* image_offset */
+    );
+  }
+
+  static void TearDownTestSuite()
+  {
+    unmount_root_memfs();
+  }
+
+  //  Builds a random relative path out of components that exercise every normalization rule
+  static std::string random_path(std::mt19937& gen)
+  {
+    static const char* components[] = {"a", "bb", ".", "..", "", "c.d", "...", ".hidden", "3.3.0", "lib"};
+    std::string path;
+    int n = gen() % 8;
+    for (int i = 0; i < n; i++) {
+      if (i > 0) {
+        path += (gen() % 4 == 0) ? __S__ : "/";
+      }
+      path += components[gen() % (sizeof(components) / sizeof(components[0]))];
+    }
+    if (gen() % 3 == 0) {
+      path += "/";
+    }
+    if (!path.empty() && (path[0] == '/' || path[0] == '\\')) {
+      path.insert(0, "x");
+    }
+    return path;
+  }
+
+  static std::string reference(const std::string& base, const std::string& path)
+  {
+    return (stdfs::path(base) / stdfs::path(path).lexically_normal()).lexically_normal().generic_string();
+  }
+};
+
+TEST_F(PathNormalizeTests, differential_lexically_normal)
+{
+  std::mt19937 gen(20251019);
+  std::vector<char> buf(TEBAKO_PATH_LENGTH);
+  tebako_small_path t_path;
+
+  EXPECT_EQ(0, tebako_chdir(TEBAKIZE_PATH("directory-1")));
+  for (int i = 0; i < 20000; i++) {
+    std::string path = random_path(gen);
+    //  Vary the alignment of the input, since it is scanned in aligned blocks
+    char* p = &buf[gen() % 32];
+    memcpy(p, path.c_str(), path.size() + 1);
+
+    const char* r = to_tebako_path(t_path, p);
+    ASSERT_NE(r, nullptr) << path;
+    EXPECT_EQ(reference(TEBAKIZE_PATH("directory-1/"), path), r) << path;
+
+    std::string absolute = std::string(TEBAKIZE_PATH("")) + path;
+    memcpy(p, absolute.c_str(), absolute.size() + 1);
+    r = to_tebako_path(t_path, p);
+    ASSERT_NE(r, nullptr) << absolute;
+    EXPECT_EQ(stdfs::path(absolute).lexically_normal().generic_string(), r) << absolute;
+  }
+}
+
+TEST_F(PathNormalizeTests, small_path_spill)
+{
+  EXPECT_EQ(0, tebako_chdir(TEBAKIZE_PATH("directory-1")));
+
+  std::string path = "level-2";
+  while (path.size() <= tebako_small_path::inline_length) {
+    path += "/component";
+  }
+  tebako_small_path t_path;
+  const char* r = to_tebako_path(t_path, path.c_str());
+  ASSERT_NE(r, nullptr);
+  EXPECT_EQ(reference(TEBAKIZE_PATH("directory-1/"), path), r);
+  EXPECT_EQ(strlen(r), t_path.length());
+  EXPECT_LT(tebako_small_path::inline_length, t_path.capacity());
+
+  r = to_tebako_path(t_path, "file-in-directory-1.txt");
+  ASSERT_NE(r, nullptr);
+  EXPECT_EQ(reference(TEBAKIZE_PATH("directory-1/"), "file-in-directory-1.txt"), r);
+  EXPECT_EQ(strlen(r), t_path.length());
+}
+
+TEST_F(PathNormalizeTests, long_paths)
+{
+  tebako_small_path t_path;
+  EXPECT_EQ(0, tebako_chdir(TEBAKIZE_PATH("directory-1")));
+
+  std::string path;
+  while (path.size() < TEBAKO_PATH_LENGTH) {
+    path += "directory/";
+  }
+  path += "../..";
+  const char* r = to_tebako_path(t_path, path.c_str());
+  ASSERT_NE(r, nullptr);
+  EXPECT_EQ(0, strncmp(r, reference(TEBAKIZE_PATH("directory-1/"), path).c_str(), TEBAKO_PATH_LENGTH));
+}
+
+//  Run with --gtest_also_run_disabled_tests to compare against std::filesystem
+TEST_F(PathNormalizeTests, DISABLED_benchmark)
+{
+  const char* paths[] = {"lib/ruby/gems/3.3.0/gems/rake-13.1.0/lib/rake/file_utils_ext.rb",
+                         "lib/ruby/3.3.0/../3.3.0/./rubygems/specification.rb",
+                         TEBAKIZE_PATH("local/lib/ruby/site_ruby/3.3.0/bundler/setup.rb")};
+  const int iterations = 1000000;
+  tebako_small_path t_path;
+  EXPECT_EQ(0, tebako_chdir(TEBAKIZE_PATH("directory-1")));
+
+  for (const char* path : paths) {
+    size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      sink += strlen(to_tebako_path(t_path, path));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      sink += reference(TEBAKIZE_PATH("directory-1/"), path).size();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::cout << path << ": to_tebako_path " << std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations
+              << " ns, lexically_normal " << std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations
+              << " ns (" << sink << ")" << std::endl;
+  }
+}
+}  // namespace
@@ -39,8 +39,8 @@ namespace tebako {
 class ProcessMountpointsTest : public ::testing::Test {
  protected:
   struct stat st;
-  static uint32_t test_root_ino;
-  static uint32_t test_dir_ino;
+  static tebako_ino_t test_root_ino;
+  static tebako_ino_t test_dir_ino;
 
 #ifdef _WIN32
   static void invalidParameterHandler(const wchar_t* p1,
@@ -90,7 +90,7 @@ class ProcessMountpointsTest : public ::testing::Test {
   }
 };
 
-uint32_t ProcessMountpointsTest::test_root_ino, ProcessMountpointsTest::test_dir_ino;
+tebako_ino_t ProcessMountpointsTest::test_root_ino, ProcessMountpointsTest::test_dir_ino;
 
 // Test: Valid mount point
 TEST_F(ProcessMountpointsTest, valid_mountpoint)
@@ -209,6 +209,49 @@ TEST_F(ProcessMountpointsTest, valid_dwarfs_mount)
   EXPECT_TRUE(sync_tebako_mount_table::get_tebako_mount_table().check(test_dir_ino, "dfs-link"));
 }
 
+// Test: Several images, the first rule mounts into the folder of the image mounted by the second one
+TEST_F(ProcessMountpointsTest, multiple_dwarfs_mounts)
+{
+  auto mp_nested = std::string("--tebako-mount=directory-1/dfs-link-1/nested>") + tests_the_other_memfs_image();
+  auto mp_1 = std::string("--tebako-mount=directory-1/dfs-link-1>") + tests_the_other_memfs_image();
+  auto mp_2 = std::string("--tebako-mount=directory-1/dfs-link-2>") + tests_the_other_memfs_image();
+
+  const int argc = 4;
+  const char* argv[argc] = {"program", mp_nested.c_str(), mp_1.c_str(), mp_2.c_str()};
+
+  cmdline_args args(argc, argv);
+  args.parse_arguments();
+
+  EXPECT_NO_THROW(args.process_mountpoints());
+  EXPECT_TRUE(sync_tebako_mount_table::get_tebako_mount_table().check(test_dir_ino, "dfs-link-1"));
+  EXPECT_TRUE(sync_tebako_mount_table::get_tebako_mount_table().check(test_dir_ino, "dfs-link-2"));
+
+  std::string lnk;
+  EXPECT_EQ(DWARFS_IO_CONTINUE, dwarfs_stat(TEBAKIZE_PATH("directory-1/dfs-link-2/fs2-file.txt"), &st, lnk, false));
+  EXPECT_EQ(DWARFS_IO_CONTINUE,
+            dwarfs_stat(TEBAKIZE_PATH("directory-1/dfs-link-1/nested/fs2-file.txt"), &st, lnk, false));
+}
+
+TEST_F(ProcessMountpointsTest, overlay_dwarfs_mount)
+{
+  // The same mount point twice stacks the images
+  auto mp = std::string("--tebako-mount=directory-1/dfs-overlay>") + tests_the_other_memfs_image();
+
+  const int argc = 3;
+  const char* argv[argc] = {"program", mp.c_str(), mp.c_str()};
+
+  cmdline_args args(argc, argv);
+  args.parse_arguments();
+
+  EXPECT_NO_THROW(args.process_mountpoints());
+  auto mount_point = sync_tebako_mount_table::get_tebako_mount_table().get(test_dir_ino, "dfs-overlay");
+  ASSERT_TRUE(mount_point.has_value());
+  EXPECT_TRUE(std::holds_alternative<std::shared_ptr<memfs_overlay>>(*mount_point));
+
+  std::string lnk;
+  EXPECT_EQ(DWARFS_IO_CONTINUE, dwarfs_stat(TEBAKIZE_PATH("directory-1/dfs-overlay/fs2-file.txt"), &st, lnk, false));
+}
+
 TEST_F(ProcessMountpointsTest, no_file_dwarfs_mount)
 {
   const int argc = 2;
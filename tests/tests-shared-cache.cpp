@@ -0,0 +1,187 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+struct tebako_dirent;
+
+#include <tebako-io-inner.h>
+
+#ifdef _WIN32
+#undef lseek
+#undef close
+#undef read
+#undef pread
+
+#undef chdir
+#undef mkdir
+#undef rmdir
+#undef unlink
+#undef access
+#undef fstat
+#undef stat
+#undef lstat
+#undef getcwd
+#undef opendir
+#undef readdir
+#undef telldir
+#undef seekdir
+#undef rewinddir
+#undef closedir
+#endif
+
+#include <tebako-memfs.h>
+#include <tebako-memfs.h>
+#include <tebako-shared-cache.h>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+
+namespace tebako {
+
+TEST(SharedCacheTests, put_and_read)
+{
+  shared_cache cache(static_cast<size_t>(8) << 20, shared_cache::default_max_entry_size);
+  ASSERT_TRUE(cache.is_available());
+
+  char buf[64];
+  EXPECT_EQ(shared_cache::miss, cache.read(5, buf, sizeof(buf), 0));
+
+  const std::string content = "hello world";
+  EXPECT_TRUE(cache.put(5, content.data(), content.size()));
+  EXPECT_FALSE(cache.put(5, content.data(), content.size()));
+
+  EXPECT_EQ(11, cache.read(5, buf, sizeof(buf), 0));
+  EXPECT_EQ(content, std::string(buf, 11));
+  EXPECT_EQ(3, cache.read(5, buf, 3, 6));
+  EXPECT_EQ("wor", std::string(buf, 3));
+  EXPECT_EQ(0, cache.read(5, buf, sizeof(buf), 20));
+}
+
+TEST(SharedCacheTests, entry_size_limit)
+{
+  shared_cache cache(static_cast<size_t>(8) << 20, 16);
+  char buf[64];
+  const std::string content = "too long to be cached";
+  EXPECT_FALSE(cache.put(5, content.data(), content.size()));
+  EXPECT_EQ(shared_cache::not_cacheable, cache.read(5, buf, sizeof(buf), 0));
+}
+
+TEST(SharedCacheTests, shared_with_child_process)
+{
+  shared_cache cache(static_cast<size_t>(8) << 20, shared_cache::default_max_entry_size);
+  pid_t pid = fork();
+  if (pid == 0) {
+    const std::string content = "from child";
+    _exit(cache.put(7, content.data(), content.size()) ? 0 : 1);
+  }
+  ASSERT_LT(0, pid);
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+
+  char buf[64];
+  EXPECT_EQ(10, cache.read(7, buf, sizeof(buf), 0));
+  EXPECT_EQ("from child", std::string(buf, 10));
+}
+
+TEST(SharedCacheTests, flush_when_full)
+{
+  shared_cache cache(static_cast<size_t>(8) << 20, shared_cache::default_max_entry_size);
+  const std::string content = "hello world";
+  EXPECT_TRUE(cache.put(5, content.data(), content.size()));
+
+  std::vector<char> big(shared_cache::default_max_entry_size, 'x');
+  uint64_t epoch = cache.epoch();
+  for (uint32_t i = 100; cache.epoch() == epoch && i < 200; ++i) {
+    cache.put(i, big.data(), big.size());
+  }
+  EXPECT_EQ(epoch + 2, cache.epoch());
+
+  char buf[64];
+  EXPECT_EQ(shared_cache::miss, cache.read(5, buf, sizeof(buf), 0));
+  EXPECT_TRUE(cache.put(5, content.data(), content.size()));
+  EXPECT_EQ(11, cache.read(5, buf, sizeof(buf), 0));
+}
+
+TEST(SharedCacheTests, concurrent_put_and_flush)
+{
+  // Small cache, so that writers flush it all the time
+  shared_cache cache(static_cast<size_t>(4) << 20, static_cast<size_t>(256) << 10);
+  auto pattern = [](uint32_t inode) { return static_cast<char>('a' + inode % 26); };
+
+  std::atomic<bool> damaged{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, &damaged, &pattern, t]() {
+      std::vector<char> content(static_cast<size_t>(200) << 10);
+      std::vector<char> buf(content.size());
+      for (uint32_t i = 0; i < 2000; ++i) {
+        uint32_t inode = (i * 7 + t) % 64;
+        ssize_t n = cache.read(inode, buf.data(), buf.size(), 0);
+        if (n > 0 && std::count(buf.begin(), buf.begin() + n, pattern(inode)) != n) {
+          damaged = true;
+        }
+        else if (n == shared_cache::miss) {
+          std::fill(content.begin(), content.end(), pattern(inode));
+          cache.put(inode, content.data(), content.size());
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(damaged);
+}
+
+TEST(SharedCacheTests, mount_with_shared_cache)
+{
+  memfs::set_shared_cache("16M");
+  EXPECT_EQ(static_cast<size_t>(16) << 20, memfs::options().shared_cache_size);
+  int ret = mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), nullptr /* cachesize*/, nullptr /* workers */,
+                             nullptr /* mlock */, nullptr /* decompress_ratio*/, nullptr /* image_offset */
+  );
+  EXPECT_EQ(0, ret);
+
+  for (int pass = 0; pass < 2; ++pass) {
+    char buf[64] = {0};
+    int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+    EXPECT_LT(0, fh);
+    EXPECT_EQ(11, tebako_read(fh, buf, 11));
+    EXPECT_STREQ("Just a file", buf);
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+
+  unmount_root_memfs();
+  memfs::set_shared_cache(nullptr);
+}
+
+}  // namespace tebako
+#endif
@@ -0,0 +1,125 @@
+/**
+ *
+ * Copyright (c) 2026, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+#include <tebako-stat-cache.h>
+
+namespace tebako {
+
+TEST(StatCacheTests, put_get)
+{
+  inode_stat_cache cache;
+  struct stat st;
+  memset(&st, 0, sizeof(st));
+  cache.put(0, st);
+  EXPECT_EQ(nullptr, cache.get(0));  // not sized yet
+
+  cache.reserve(inode_stat_cache::chunk_size + 10);
+  cache.reserve(5);
+  EXPECT_EQ(inode_stat_cache::chunk_size + 10, cache.capacity());
+
+  st.st_size = 42;
+  cache.put(inode_stat_cache::chunk_size + 1, st);
+  const struct stat* cached = cache.get(inode_stat_cache::chunk_size + 1);
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(42, cached->st_size);
+  EXPECT_EQ(nullptr, cache.get(inode_stat_cache::chunk_size));
+  EXPECT_EQ(nullptr, cache.get(1));
+
+  // Slots are written once
+  st.st_size = 43;
+  cache.put(inode_stat_cache::chunk_size + 1, st);
+  EXPECT_EQ(42, cache.get(inode_stat_cache::chunk_size + 1)->st_size);
+
+  cache.put(inode_stat_cache::chunk_size + 10, st);
+  EXPECT_EQ(nullptr, cache.get(inode_stat_cache::chunk_size + 10));
+}
+
+TEST(StatCacheTests, concurrent_fill)
+{
+  const uint32_t n = 3 * inode_stat_cache::chunk_size;
+  inode_stat_cache cache;
+  cache.reserve(n);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, n]() {
+      struct stat st;
+      memset(&st, 0, sizeof(st));
+      for (uint32_t i = 0; i < n; i++) {
+        st.st_size = i;
+        cache.put(i, st);
+        const struct stat* cached = cache.get(i);
+        if (cached != nullptr) {
+          EXPECT_EQ(static_cast<off_t>(i), cached->st_size);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    ASSERT_NE(nullptr, cache.get(i));
+    EXPECT_EQ(static_cast<off_t>(i), cache.get(i)->st_size);
+  }
+}
+
+TEST(StatCacheTests, memfs_stat)
+{
+  int ret = mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), nullptr /* cachesize*/, nullptr /* workers */,
+                             nullptr /* mlock */, nullptr /* decompress_ratio*/, nullptr /* image_offset */
+  );
+  EXPECT_EQ(0, ret);
+
+  // The second stat is served from the cache and the inode is still the composite one
+  struct STAT_TYPE st1, st2;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"), &st1));
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"), &st2));
+  EXPECT_EQ(st1.st_ino, st2.st_ino);
+  EXPECT_EQ(st1.st_size, st2.st_size);
+  EXPECT_EQ(st1.st_mode, st2.st_mode);
+  EXPECT_TRUE(S_ISREG(st2.st_mode));
+
+  int fh = tebako_open(2, TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"), O_RDONLY);
+  EXPECT_LT(0, fh);
+  EXPECT_EQ(0, tebako_fstat(fh, &st2));
+  EXPECT_EQ(st1.st_ino, st2.st_ino);
+  EXPECT_EQ(st1.st_size, st2.st_size);
+  EXPECT_EQ(0, tebako_close(fh));
+
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("directory-1"), &st1));
+  EXPECT_TRUE(S_ISDIR(st1.st_mode));
+  EXPECT_EQ(-1, tebako_stat(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt/no-file"), &st1));
+  EXPECT_EQ(ENOTDIR, errno);
+
+  unmount_root_memfs();
+}
+
+}  // namespace tebako